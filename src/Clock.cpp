@@ -37,4 +37,9 @@ Clock::OptionalSimTime Clock::convertToSimulationTimestamp(const omnetpp::SimTim
   throw omnetpp::cRuntimeError("Called default Clock::convertToSimulationTimestamp() implementation");
 }
 
+size_t Clock::convertToSimulationTimestamps(const std::vector<omnetpp::SimTime>&, std::vector<omnetpp::SimTime>&)
+{
+  throw omnetpp::cRuntimeError("Called default Clock::convertToSimulationTimestamps() implementation");
+}
+
 }  // namespace smile
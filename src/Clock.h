@@ -35,6 +35,8 @@ class Clock : public omnetpp::cSimpleModule, public IClock
 
   omnetpp::SimTime getClockTimestamp() override;
   OptionalSimTime convertToSimulationTimestamp(const omnetpp::SimTime& timestamp) override;
+  size_t convertToSimulationTimestamps(const std::vector<omnetpp::SimTime>& timestamps,
+                                       std::vector<omnetpp::SimTime>& simulationTimestamps) override;
 
  protected:
   int numInitStages() const final;
@@ -20,42 +20,73 @@
 #include <inet/common/INETDefs.h>
 #include <omnetpp.h>
 #include <algorithm>
-#include <list>
+#include <functional>
 #include <memory>
 #include <string>
 #include <type_traits>
+#include "ClockTimer.h"
+#include "ClockTimerService.h"
 #include "IClock.h"
+#include "IdealClock.h"
+#include "utilities.h"
 
 namespace smile {
 
-namespace clock_decorator_details {
-
-struct Message final
+// Part of ClockDecorator that doesn't depend on clock policy: pooled timers and dispatching of received messages
+template <class BaseModule>
+class ClockDecoratorBase : public BaseModule, public cListener
 {
-  Message() = default;
-  Message(std::unique_ptr<cMessage> newMessage, const SimTime& newClockTimestamp, cGate* newGate);
+  static_assert(std::is_base_of<cModule, BaseModule>::value, "ClockDecorator has t derive from cModule");
 
-  Message(const Message& source) = delete;
-  Message(Message&& source) = default;
-  ~Message() = default;
+ public:
+  ClockDecoratorBase() = default;
+  ClockDecoratorBase(const ClockDecoratorBase& source) = delete;
+  ClockDecoratorBase(ClockDecoratorBase&& source) = delete;
+  ~ClockDecoratorBase();
 
-  Message& operator=(const Message& source) = delete;
-  Message& operator=(Message&& source) = default;
+  ClockDecoratorBase& operator=(const ClockDecoratorBase& source) = delete;
+  ClockDecoratorBase& operator=(ClockDecoratorBase&& source) = delete;
 
-  std::unique_ptr<cMessage> message;
-  SimTime clockTimestamp;
-  cGate* gate{nullptr};  // Self messages has nullptr gate
-};
+  // Returns timer from the module's pool, it can be armed with scheduleAt() and rescheduleAt() repeatedly
+  ClockTimer* acquireTimer(const char* name = "clockTimer", short kind = 0);
 
-};  // namespace clock_decorator_details
+  // Cancels the timer and returns it to the pool
+  void releaseTimer(ClockTimer* timer);
 
-template <class BaseModule>
-class ClockDecorator : public BaseModule, public cListener
-{
-  static_assert(std::is_base_of<cModule, BaseModule>::value, "ClockDecorator has t derive from cModule");
+  const ClockTimerPool& getTimerPool() const;
+
+  using Continuation = std::function<void()>;
+
+  // Calls continuation when local clock reaches clockTimestamp. Timers are pooled, so protocol steps can be
+  // chained without allocating a self message per step and without dispatching in handleSelfMessage().
+  void sleepUntilClock(const SimTime& clockTimestamp, Continuation continuation);
+
+ protected:
+  void initialize(int stage) override;
+
+  void handleMessage(cMessage* message) override final;
+
+  // Records statistics of the timer pool, if it was used
+  void finish() override;
+
+  virtual void handleSelfMessage(cMessage* message);
+
+  virtual void handleIncommingMessage(cMessage* message);
+
+  cModule* clockModule{nullptr};
 
  private:
-  using ScheduledMessagesList = std::list<clock_decorator_details::Message>;
+  void handleWaitTimer(ClockTimer* timer);
+
+  ClockTimerPool timerPool;
+};
+
+// Clock is accessed through ClockPolicy interface, by default it's IClock, so any clock module selected in
+// configuration can be used. Timestamps that can't be converted yet are kept by clock's timer service.
+template <class BaseModule, class ClockPolicy = IClock>
+class ClockDecorator : public ClockDecoratorBase<BaseModule>, private ClockTimerService::IClient
+{
+  static_assert(std::is_base_of<IClock, ClockPolicy>::value, "ClockDecorator policy has to derive from IClock");
 
  public:
   ClockDecorator() = default;
@@ -68,6 +99,11 @@ class ClockDecorator : public BaseModule, public cListener
 
   void scheduleAt(simtime_t clockTimestamp, cMessage* message) override final;
 
+  // Works both for messages in the FES and for messages waiting for conversion of their clock timestamps
+  cMessage* cancelEvent(cMessage* message) override final;
+
+  void rescheduleAt(simtime_t clockTimestamp, cMessage* message);
+
   void sendDelayed(cMessage* message, simtime_t delay, int gateID) override final;
 
   void sendDelayed(cMessage* message, simtime_t delay, const char* gateName, int gateIndex = -1) override final;
@@ -79,40 +115,158 @@ class ClockDecorator : public BaseModule, public cListener
  protected:
   void initialize(int stage) override;
 
-  void handleMessage(cMessage* message) override final;
+ private:
+  void scheduleMessage(std::unique_ptr<cMessage> message, const SimTime& clockTimestamp, cGate* gate);
 
-  void receiveSignal(cComponent* source, simsignal_t signalID, const SimTime& value, cObject* details) override;
+  void releaseScheduledMessage(cMessage* message, cGate* gate, const SimTime& simulationTimestamp) override;
 
-  virtual void handleSelfMessage(cMessage* message);
+  ClockPolicy* clock{nullptr};
+  std::shared_ptr<ClockTimerService> timerService;
+  mutable EventMemo<SimTime> clockTimeMemo;
+};
 
-  virtual void handleIncommingMessage(cMessage* message);
+// IdealClock policy is meant for configurations that always use IdealClock. Clock time is simulation time, so
+// scheduleAt(), cancelEvent() and sendDelayed() are plain BaseModule calls and timer service isn't used at all.
+template <class BaseModule>
+class ClockDecorator<BaseModule, IdealClock> : public ClockDecoratorBase<BaseModule>
+{
+ public:
+  ClockDecorator() = default;
+  ClockDecorator(const ClockDecorator& source) = delete;
+  ClockDecorator(ClockDecorator&& source) = delete;
+  ~ClockDecorator() = default;
 
- private:
-  void scheduleMessage(std::unique_ptr<cMessage> message, const SimTime& clockTimestamp, cGate* gate);
+  ClockDecorator& operator=(const ClockDecorator& source) = delete;
+  ClockDecorator& operator=(ClockDecorator&& source) = delete;
 
-  void handleSendScheduledMessagesSelfMessage();
+  void rescheduleAt(simtime_t clockTimestamp, cMessage* message);
 
-  IClock* clock{nullptr};
-  cModule* clockModule{nullptr};
-  ScheduledMessagesList scheduledMessages;
-  std::unique_ptr<cMessage> sendScheduledMessagesSelfMessage;
+  SimTime clockTime() const;
+
+ protected:
+  void initialize(int stage) override;
 };
 
 template <typename BaseModule>
-ClockDecorator<BaseModule>::~ClockDecorator()
+ClockDecoratorBase<BaseModule>::~ClockDecoratorBase()
+{
+  // Pooled timers are deleted with the pool, so they can't be left in the FES
+  for (const auto& timer : timerPool.getTimers()) {
+    BaseModule::cancelEvent(timer.get());
+  }
+}
+
+template <typename BaseModule>
+ClockTimer* ClockDecoratorBase<BaseModule>::acquireTimer(const char* name, short kind)
+{
+  return timerPool.acquire(name, kind);
+}
+
+template <typename BaseModule>
+void ClockDecoratorBase<BaseModule>::releaseTimer(ClockTimer* timer)
+{
+  this->cancelEvent(timer);
+  timerPool.release(timer);
+}
+
+template <typename BaseModule>
+const ClockTimerPool& ClockDecoratorBase<BaseModule>::getTimerPool() const
+{
+  return timerPool;
+}
+
+template <typename BaseModule>
+void ClockDecoratorBase<BaseModule>::sleepUntilClock(const SimTime& clockTimestamp, Continuation continuation)
 {
-  for (auto& element : scheduledMessages) {
-    // Self massages are managed by objects that created them, don't delete them here
-    if (!element.gate) {
-      element.message.release();
+  auto timer = timerPool.acquire("clockWait", 0);
+  timer->continuation = std::move(continuation);
+  // Marks the timer for handleMessage(), other messages never refer to the pool
+  timer->setContextPointer(&timerPool);
+  this->scheduleAt(clockTimestamp, timer);
+}
+
+template <typename BaseModule>
+void ClockDecoratorBase<BaseModule>::initialize(int stage)
+{
+  BaseModule::initialize(stage);
+
+  if (stage == inet::INITSTAGE_LOCAL) {
+    clockModule = BaseModule::getModuleByPath(BaseModule::par("clockModule").stringValue());
+    if (!clockModule) {
+      throw cRuntimeError{"Failed to find clock module at relative path \"%s\"",
+                          BaseModule::par("clockModule").stringValue()};
     }
   }
+}
 
-  BaseModule::cancelEvent(sendScheduledMessagesSelfMessage.get());
+template <typename BaseModule>
+void ClockDecoratorBase<BaseModule>::handleMessage(cMessage* message)
+{
+  if (message->isSelfMessage()) {
+    if (message->getContextPointer() == &timerPool) {
+      handleWaitTimer(static_cast<ClockTimer*>(message));
+    }
+    else {
+      handleSelfMessage(message);
+    }
+  }
+  else {
+    handleIncommingMessage(message);
+  }
 }
 
 template <typename BaseModule>
-void ClockDecorator<BaseModule>::scheduleAt(simtime_t clockTimestamp, cMessage* message)
+void ClockDecoratorBase<BaseModule>::finish()
+{
+  BaseModule::finish();
+
+  // Modules that never used the pool don't record anything
+  if (timerPool.getAllocated() == 0) {
+    return;
+  }
+
+  BaseModule::recordScalar("clockTimersOutstanding", timerPool.getOutstanding());
+  BaseModule::recordScalar("clockTimersPeak", timerPool.getPeak());
+  BaseModule::recordScalar("clockTimersAllocated", timerPool.getAllocated());
+}
+
+template <typename BaseModule>
+void ClockDecoratorBase<BaseModule>::handleWaitTimer(ClockTimer* timer)
+{
+  // Timer is returned to the pool first, so the continuation can wait again using the same timer
+  auto continuation = std::move(timer->continuation);
+  timerPool.release(timer);
+
+  continuation();
+}
+
+template <typename BaseModule>
+void ClockDecoratorBase<BaseModule>::handleSelfMessage(cMessage* message)
+{
+  throw cRuntimeError{"Default ClockDecorator::handleSelfMessage() implementation received message"};
+}
+
+template <typename BaseModule>
+void ClockDecoratorBase<BaseModule>::handleIncommingMessage(cMessage* message)
+{
+  throw cRuntimeError{"Default ClockDecorator::handleIncommingMessage() implementation received message"};
+}
+
+template <typename BaseModule, typename ClockPolicy>
+ClockDecorator<BaseModule, ClockPolicy>::~ClockDecorator()
+{
+  // Service may outlive the clock module, so messages are removed from it even if the clock was already deleted
+  if (timerService) {
+    for (const auto& timer : this->getTimerPool().getTimers()) {
+      timerService->cancel(timer.get());
+    }
+
+    timerService->cancel(this);
+  }
+}
+
+template <typename BaseModule, typename ClockPolicy>
+void ClockDecorator<BaseModule, ClockPolicy>::scheduleAt(simtime_t clockTimestamp, cMessage* message)
 {
   EV_DEBUG << "Calling ClockDecorator<BaseModule>::scheduleAt()" << endl;
   const auto simulationTime = clock->convertToSimulationTimestamp(clockTimestamp);
@@ -124,8 +278,27 @@ void ClockDecorator<BaseModule>::scheduleAt(simtime_t clockTimestamp, cMessage*
   }
 }
 
-template <typename BaseModule>
-void ClockDecorator<BaseModule>::sendDelayed(cMessage* message, simtime_t delay, int gateID)
+template <typename BaseModule, typename ClockPolicy>
+cMessage* ClockDecorator<BaseModule, ClockPolicy>::cancelEvent(cMessage* message)
+{
+  // Timer service is missing if the module wasn't initialized, e.g. in a destructor after failed initialization
+  if (timerService && timerService->cancel(message)) {
+    EV_DETAIL << "Cancelled message \"" << message << "\" scheduled according to local clock" << endl;
+    return message;
+  }
+
+  return BaseModule::cancelEvent(message);
+}
+
+template <typename BaseModule, typename ClockPolicy>
+void ClockDecorator<BaseModule, ClockPolicy>::rescheduleAt(simtime_t clockTimestamp, cMessage* message)
+{
+  cancelEvent(message);
+  scheduleAt(clockTimestamp, message);
+}
+
+template <typename BaseModule, typename ClockPolicy>
+void ClockDecorator<BaseModule, ClockPolicy>::sendDelayed(cMessage* message, simtime_t delay, int gateID)
 {
   const auto clockTimestamp = clockTime() + delay;
   const auto simulationTime = clock->convertToSimulationTimestamp(clockTimestamp);
@@ -138,8 +311,9 @@ void ClockDecorator<BaseModule>::sendDelayed(cMessage* message, simtime_t delay,
   }
 }
 
-template <typename BaseModule>
-void ClockDecorator<BaseModule>::sendDelayed(cMessage* message, simtime_t delay, const char* gateName, int gateIndex)
+template <typename BaseModule, typename ClockPolicy>
+void ClockDecorator<BaseModule, ClockPolicy>::sendDelayed(cMessage* message, simtime_t delay, const char* gateName,
+                                                          int gateIndex)
 {
   const auto clockTimestamp = clockTime() + delay;
   const auto simulationTime = clock->convertToSimulationTimestamp(clockTimestamp);
@@ -152,8 +326,8 @@ void ClockDecorator<BaseModule>::sendDelayed(cMessage* message, simtime_t delay,
   }
 }
 
-template <typename BaseModule>
-void ClockDecorator<BaseModule>::sendDelayed(cMessage* message, simtime_t delay, cGate* outputGate)
+template <typename BaseModule, typename ClockPolicy>
+void ClockDecorator<BaseModule, ClockPolicy>::sendDelayed(cMessage* message, simtime_t delay, cGate* outputGate)
 {
   const auto clockTimestamp = clockTime() + delay;
   const auto simulationTime = clock->convertToSimulationTimestamp(clockTimestamp);
@@ -165,117 +339,71 @@ void ClockDecorator<BaseModule>::sendDelayed(cMessage* message, simtime_t delay,
   }
 }
 
-template <typename BaseModule>
-SimTime ClockDecorator<BaseModule>::clockTime() const
+template <typename BaseModule, typename ClockPolicy>
+SimTime ClockDecorator<BaseModule, ClockPolicy>::clockTime() const
 {
-  return clock->getClockTimestamp();
+  // Clock time depends only on simulation time, which doesn't change within an event
+  return clockTimeMemo.get([this] { return clock->getClockTimestamp(); });
 }
 
-template <typename BaseModule>
-void ClockDecorator<BaseModule>::initialize(int stage)
+template <typename BaseModule, typename ClockPolicy>
+void ClockDecorator<BaseModule, ClockPolicy>::initialize(int stage)
 {
-  BaseModule::initialize(stage);
+  ClockDecoratorBase<BaseModule>::initialize(stage);
 
   if (stage == inet::INITSTAGE_LOCAL) {
-    clockModule = BaseModule::getModuleByPath(BaseModule::par("clockModule").stringValue());
-    if (!clockModule) {
-      throw cRuntimeError{"Failed to find clock module at relative path \"%s\"", clockModule};
-    }
-    clock = check_and_cast<IClock*>(clockModule);
-
-    sendScheduledMessagesSelfMessage = std::make_unique<cMessage>("sendScheduledMessagesSelfMessage");
+    clock = check_and_cast<ClockPolicy*>(this->clockModule);
+    timerService = clock->getTimerService();
   }
 }
 
-template <typename BaseModule>
-void ClockDecorator<BaseModule>::handleMessage(cMessage* message)
+template <typename BaseModule, typename ClockPolicy>
+void ClockDecorator<BaseModule, ClockPolicy>::scheduleMessage(std::unique_ptr<cMessage> message,
+                                                              const SimTime& clockTimestamp, cGate* gate)
 {
-  if (message->isSelfMessage()) {
-    if (message == sendScheduledMessagesSelfMessage.get()) {
-      handleSendScheduledMessagesSelfMessage();
-    }
-    else {
-      handleSelfMessage(message);
-    }
-  }
-  else {
-    handleIncommingMessage(message);
-  }
+  EV_DETAIL << "Scheduling message \"" << message.get() << "\" according to local clock" << endl;
+
+  timerService->schedule(this, message.release(), clockTimestamp, gate);
 }
 
-template <typename BaseModule>
-void ClockDecorator<BaseModule>::receiveSignal(cComponent* source, simsignal_t signalID, const SimTime& value,
-                                               cObject* details)
+template <typename BaseModule, typename ClockPolicy>
+void ClockDecorator<BaseModule, ClockPolicy>::releaseScheduledMessage(cMessage* message, cGate* gate,
+                                                                      const SimTime& simulationTimestamp)
 {
-  EV_DEBUG << "Received signal " << BaseModule::getSignalName(signalID) << endl;
+  Enter_Method_Silent();
 
-  if (signalID == IClock::windowUpdateSignal) {
-    const auto& firstMessage = scheduledMessages.front();
-    if (firstMessage.clockTimestamp <= value) {
-      BaseModule::scheduleAt(simTime(), sendScheduledMessagesSelfMessage.get());
-    }
+  EV_DETAIL << "Sending scheduled message " << message << " according to local clock" << endl;
+
+  if (!gate) {
+    BaseModule::scheduleAt(simulationTimestamp, message);
   }
   else {
-    throw cRuntimeError{"Received unexpected signal \"%s\"", BaseModule::getSignalName(signalID)};
+    const auto delay = simulationTimestamp - simTime();
+    BaseModule::sendDelayed(message, delay, gate);
   }
 }
 
 template <typename BaseModule>
-void ClockDecorator<BaseModule>::handleSelfMessage(cMessage* message)
+void ClockDecorator<BaseModule, IdealClock>::rescheduleAt(simtime_t clockTimestamp, cMessage* message)
 {
-  throw cRuntimeError{"Default ClockDecorator::handleSelfMessage() implementation received message"};
-}
-
-template <typename BaseModule>
-void ClockDecorator<BaseModule>::handleIncommingMessage(cMessage* message)
-{
-  throw cRuntimeError{"Default ClockDecorator::handleIncommingMessage() implementation received message"};
+  BaseModule::cancelEvent(message);
+  BaseModule::scheduleAt(clockTimestamp, message);
 }
 
 template <typename BaseModule>
-void ClockDecorator<BaseModule>::scheduleMessage(std::unique_ptr<cMessage> message, const SimTime& clockTimestamp,
-                                                 cGate* gate)
+SimTime ClockDecorator<BaseModule, IdealClock>::clockTime() const
 {
-  if (scheduledMessages.empty()) {
-    clockModule->subscribe(IClock::windowUpdateSignal, this);
-    EV_DEBUG << "Subscribe on signal " << BaseModule::getSignalName(IClock::windowUpdateSignal) << endl;
-  }
-
-  auto predicate = [](const auto& element, const auto& clockTimestamp) {
-    return element.clockTimestamp < clockTimestamp ? true : false;
-  };
-
-  EV_DETAIL << "Scheduling message \"" << message.get() << "\" according to local clock" << endl;
-
-  auto element = std::lower_bound(scheduledMessages.begin(), scheduledMessages.end(), clockTimestamp, predicate);
-  scheduledMessages.emplace(element, std::move(message), clockTimestamp, gate);
+  return simTime();
 }
 
 template <typename BaseModule>
-void ClockDecorator<BaseModule>::handleSendScheduledMessagesSelfMessage()
+void ClockDecorator<BaseModule, IdealClock>::initialize(int stage)
 {
-  for (auto element = scheduledMessages.begin(); element != scheduledMessages.end();) {
-    const auto simulationTime = clock->convertToSimulationTimestamp(element->clockTimestamp);
-    if (!simulationTime) {
-      break;
-    }
-
-    EV_DETAIL << "Sending scheduled message " << element->message.get() << " according to local clock" << endl;
-
-    if (!element->gate) {
-      BaseModule::scheduleAt(*simulationTime, element->message.release());
-    }
-    else {
-      const auto delay = *simulationTime - simTime();
-      BaseModule::sendDelayed(element->message.release(), delay, element->gate);
-    }
+  ClockDecoratorBase<BaseModule>::initialize(stage);
 
-    element = scheduledMessages.erase(element);
-  }
-
-  if (scheduledMessages.empty()) {
-    EV_DEBUG << "Unsubscribe from signal " << BaseModule::getSignalName(IClock::windowUpdateSignal) << endl;
-    clockModule->unsubscribe(IClock::windowUpdateSignal, this);
+  if (stage == inet::INITSTAGE_LOCAL) {
+    // Compile-time policy has to match the clock selected in configuration
+    check_and_cast<IdealClock*>(this->clockModule);
   }
 }
 
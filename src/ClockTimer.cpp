@@ -0,0 +1,66 @@
+//
+// Copyright (C) 2018 Tomasz Jankowski <t.jankowski AT pwr.edu.pl>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "ClockTimer.h"
+#include <algorithm>
+
+namespace smile {
+
+ClockTimer* ClockTimerPool::acquire(const char* name, short kind)
+{
+  if (freeTimers.empty()) {
+    timers.push_back(std::make_unique<ClockTimer>());
+    freeTimers.push_back(timers.back().get());
+  }
+
+  auto timer = freeTimers.back();
+  freeTimers.pop_back();
+  peak = std::max(peak, getOutstanding());
+
+  timer->setName(name);
+  timer->setKind(kind);
+  timer->setContextPointer(nullptr);
+  return timer;
+}
+
+void ClockTimerPool::release(ClockTimer* timer)
+{
+  timer->continuation = nullptr;
+  freeTimers.push_back(timer);
+}
+
+size_t ClockTimerPool::getOutstanding() const
+{
+  return timers.size() - freeTimers.size();
+}
+
+size_t ClockTimerPool::getPeak() const
+{
+  return peak;
+}
+
+size_t ClockTimerPool::getAllocated() const
+{
+  return timers.size();
+}
+
+const std::vector<std::unique_ptr<ClockTimer>>& ClockTimerPool::getTimers() const
+{
+  return timers;
+}
+
+}  // namespace smile
@@ -0,0 +1,78 @@
+//
+// Copyright (C) 2018 Tomasz Jankowski <t.jankowski AT pwr.edu.pl>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#pragma once
+
+#include <omnetpp.h>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace smile {
+
+// Self message armed according to local clock, acquired from ClockDecorator's pool and reused between runs.
+// Timers are delivered to handleSelfMessage(), unless they carry continuation set by sleepUntilClock(). Context pointer
+// of such timers refers to the pool, so they are recognized without RTTI.
+class ClockTimer final : public omnetpp::cMessage
+{
+ public:
+  ClockTimer() = default;
+  ClockTimer(const ClockTimer& source) = delete;
+  ClockTimer(ClockTimer&& source) = delete;
+  ~ClockTimer() = default;
+
+  ClockTimer& operator=(const ClockTimer& source) = delete;
+  ClockTimer& operator=(ClockTimer&& source) = delete;
+
+  std::function<void()> continuation;
+};
+
+class ClockTimerPool final
+{
+ public:
+  ClockTimerPool() = default;
+  ClockTimerPool(const ClockTimerPool& source) = delete;
+  ClockTimerPool(ClockTimerPool&& source) = delete;
+  ~ClockTimerPool() = default;
+
+  ClockTimerPool& operator=(const ClockTimerPool& source) = delete;
+  ClockTimerPool& operator=(ClockTimerPool&& source) = delete;
+
+  // Returns free timer, a new one is allocated only if all timers are outstanding
+  ClockTimer* acquire(const char* name, short kind);
+
+  // Timer has to be cancelled before it's returned to the pool
+  void release(ClockTimer* timer);
+
+  // Timers acquired and not released
+  size_t getOutstanding() const;
+
+  // The highest number of outstanding timers
+  size_t getPeak() const;
+
+  // Timers allocated by the pool, stops growing once the pool covers the peak
+  size_t getAllocated() const;
+
+  const std::vector<std::unique_ptr<ClockTimer>>& getTimers() const;
+
+ private:
+  std::vector<std::unique_ptr<ClockTimer>> timers;
+  std::vector<ClockTimer*> freeTimers;
+  size_t peak{0};
+};
+
+}  // namespace smile
@@ -0,0 +1,205 @@
+//
+// Copyright (C) 2018 Tomasz Jankowski <t.jankowski AT pwr.edu.pl>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "ClockTimerService.h"
+#include <algorithm>
+#include "IClock.h"
+
+namespace smile {
+
+namespace {
+
+const size_t releaseBatchSize = 64;
+
+}  // namespace
+
+bool ClockTimerService::LaterDelivery::operator()(const Delivery& left, const Delivery& right) const
+{
+  if (left.clockTimestamp != right.clockTimestamp) {
+    return left.clockTimestamp > right.clockTimestamp;
+  }
+
+  // Messages with equal timestamps are released in order of scheduling
+  return left.sequenceNumber > right.sequenceNumber;
+}
+
+void ClockTimerService::schedule(IClient* client, omnetpp::cMessage* message, const omnetpp::SimTime& clockTimestamp,
+                                 omnetpp::cGate* gate)
+{
+  if (contains(message)) {
+    throw omnetpp::cRuntimeError{"Message \"%s\" is already scheduled according to local clock", message->getName()};
+  }
+
+  Delivery delivery;
+  delivery.clockTimestamp = clockTimestamp;
+  delivery.sequenceNumber = deliveriesCounter++;
+  delivery.client = client;
+  delivery.message = message;
+  delivery.gate = gate;
+
+  pending.emplace(message, PendingDelivery{delivery.sequenceNumber, clockTimestamp});
+  deliveries.push_back(delivery);
+
+  // All held messages are before a message scheduled at or after the upper bound
+  if (!furthest || clockTimestamp >= *furthest) {
+    furthest = clockTimestamp;
+    furthestStale = false;
+  }
+  std::push_heap(deliveries.begin(), deliveries.end(), LaterDelivery{});
+}
+
+void ClockTimerService::cancel(IClient* client)
+{
+  auto predicate = [client](const Delivery& delivery) { return delivery.client != client; };
+  const auto first = std::partition(deliveries.begin(), deliveries.end(), predicate);
+
+  for (auto delivery = first; delivery != deliveries.end(); delivery++) {
+    if (!isLive(*delivery)) {
+      continue;
+    }
+
+    erasePending(pending.find(delivery->message));
+
+    // Self massages are managed by objects that created them, don't delete them here
+    if (delivery->gate) {
+      delete delivery->message;
+    }
+  }
+
+  deliveries.erase(first, deliveries.end());
+  std::make_heap(deliveries.begin(), deliveries.end(), LaterDelivery{});
+}
+
+bool ClockTimerService::cancel(const omnetpp::cMessage* message)
+{
+  const auto element = pending.find(message);
+  if (element == pending.end()) {
+    return false;
+  }
+
+  erasePending(element);
+
+  // The delivery stays in the heap, so keep cancelled ones from outnumbering live ones
+  if (deliveries.size() > 2 * pending.size() + releaseBatchSize) {
+    compact();
+  }
+
+  return true;
+}
+
+bool ClockTimerService::contains(const omnetpp::cMessage* message) const
+{
+  return pending.find(message) != pending.end();
+}
+
+bool ClockTimerService::isLive(const Delivery& delivery) const
+{
+  const auto element = pending.find(delivery.message);
+  return element != pending.end() && element->second.sequenceNumber == delivery.sequenceNumber;
+}
+
+void ClockTimerService::erasePending(PendingDeliveries::const_iterator element)
+{
+  if (furthest && element->second.clockTimestamp == *furthest) {
+    furthestStale = true;
+  }
+
+  pending.erase(element);
+  if (pending.empty()) {
+    furthest = {};
+    furthestStale = false;
+  }
+}
+
+void ClockTimerService::compact()
+{
+  auto predicate = [this](const Delivery& delivery) { return !isLive(delivery); };
+  deliveries.erase(std::remove_if(deliveries.begin(), deliveries.end(), predicate), deliveries.end());
+  std::make_heap(deliveries.begin(), deliveries.end(), LaterDelivery{});
+}
+
+void ClockTimerService::release(IClock& clock)
+{
+  while (!deliveries.empty()) {
+    // Cancelled deliveries on top are dropped, the earliest live one decides whether a batch is worth popping
+    if (!isLive(deliveries.front())) {
+      std::pop_heap(deliveries.begin(), deliveries.end(), LaterDelivery{});
+      deliveries.pop_back();
+      continue;
+    }
+
+    if (!clock.convertToSimulationTimestamp(deliveries.front().clockTimestamp)) {
+      break;
+    }
+
+    batch.clear();
+    batchClockTimestamps.clear();
+    while (!deliveries.empty() && batch.size() < releaseBatchSize) {
+      std::pop_heap(deliveries.begin(), deliveries.end(), LaterDelivery{});
+      if (isLive(deliveries.back())) {
+        batch.push_back(deliveries.back());
+        batchClockTimestamps.push_back(deliveries.back().clockTimestamp);
+      }
+      deliveries.pop_back();
+    }
+
+    const auto converted = clock.convertToSimulationTimestamps(batchClockTimestamps, batchSimulationTimestamps);
+
+    // Deliveries beyond the convertible horizon go back to the heap, they keep their sequence numbers
+    for (auto i = converted; i < batch.size(); i++) {
+      deliveries.push_back(batch[i]);
+      std::push_heap(deliveries.begin(), deliveries.end(), LaterDelivery{});
+    }
+
+    for (size_t i = 0; i < converted; i++) {
+      erasePending(pending.find(batch[i].message));
+      batch[i].client->releaseScheduledMessage(batch[i].message, batch[i].gate, batchSimulationTimestamps[i]);
+    }
+
+    if (converted < batch.size()) {
+      break;
+    }
+  }
+}
+
+bool ClockTimerService::empty() const
+{
+  return pending.empty();
+}
+
+size_t ClockTimerService::size() const
+{
+  return pending.size();
+}
+
+std::experimental::optional<omnetpp::SimTime> ClockTimerService::furthestClockTimestamp() const
+{
+  if (furthestStale) {
+    furthest = {};
+    for (const auto& element : pending) {
+      if (!furthest || element.second.clockTimestamp > *furthest) {
+        furthest = element.second.clockTimestamp;
+      }
+    }
+
+    furthestStale = false;
+  }
+
+  return furthest;
+}
+
+}  // namespace smile
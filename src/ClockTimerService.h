@@ -0,0 +1,129 @@
+//
+// Copyright (C) 2018 Tomasz Jankowski <t.jankowski AT pwr.edu.pl>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#pragma once
+
+#include <omnetpp.h>
+#include <cstdint>
+#include <experimental/optional>
+#include <unordered_map>
+#include <vector>
+
+namespace smile {
+
+class IClock;
+
+// Holds messages of all modules using a clock that have to be scheduled or sent according to clock time not yet
+// convertible to simulation time. Messages are released in one pass when the clock's conversion window advances.
+class ClockTimerService final
+{
+ public:
+  class IClient
+  {
+   public:
+    virtual ~IClient() = default;
+
+    // Called (in context of the clock module) when clock timestamp of the message can be converted
+    virtual void releaseScheduledMessage(omnetpp::cMessage* message, omnetpp::cGate* gate,
+                                         const omnetpp::SimTime& simulationTimestamp) = 0;
+  };
+
+  ClockTimerService() = default;
+  ClockTimerService(const ClockTimerService& source) = delete;
+  ClockTimerService(ClockTimerService&& source) = delete;
+  ~ClockTimerService() = default;
+
+  ClockTimerService& operator=(const ClockTimerService& source) = delete;
+  ClockTimerService& operator=(ClockTimerService&& source) = delete;
+
+  // Self messages have nullptr gate
+  void schedule(IClient* client, omnetpp::cMessage* message, const omnetpp::SimTime& clockTimestamp,
+                omnetpp::cGate* gate);
+
+  // Removes all messages of the client, messages to be sent are deleted
+  void cancel(IClient* client);
+
+  // Removes the message in O(1), the message isn't deleted. Returns false if the message isn't held by the service.
+  bool cancel(const omnetpp::cMessage* message);
+
+  bool contains(const omnetpp::cMessage* message) const;
+
+  // Releases all messages whose clock timestamps can be converted by the clock, in order of clock timestamps.
+  // Timestamps are converted in sorted batches, so the clock can resolve them in a single pass.
+  void release(IClock& clock);
+
+  bool empty() const;
+
+  // Returns number of messages held by the service
+  size_t size() const;
+
+  // Returns the furthest clock timestamp of held messages, or nothing if the service is empty. The maximum is kept
+  // while messages are scheduled, held messages are scanned only after the furthest one was released or cancelled.
+  std::experimental::optional<omnetpp::SimTime> furthestClockTimestamp() const;
+
+ private:
+  struct Delivery
+  {
+    omnetpp::SimTime clockTimestamp;
+    uint64_t sequenceNumber{0};
+    IClient* client{nullptr};
+    omnetpp::cMessage* message{nullptr};
+    omnetpp::cGate* gate{nullptr};
+  };
+
+  // Orders deliveries in the heap, the earliest one (and the first scheduled among equal ones) is on top
+  struct LaterDelivery
+  {
+    bool operator()(const Delivery& left, const Delivery& right) const;
+  };
+
+  struct PendingDelivery
+  {
+    uint64_t sequenceNumber{0};
+    omnetpp::SimTime clockTimestamp;
+  };
+
+  using PendingDeliveries = std::unordered_map<const omnetpp::cMessage*, PendingDelivery>;
+
+  // Returns false if the delivery was cancelled
+  bool isLive(const Delivery& delivery) const;
+
+  // Removes the message from pending ones and invalidates the furthest clock timestamp if needed
+  void erasePending(PendingDeliveries::const_iterator element);
+
+  // Removes cancelled deliveries from the heap
+  void compact();
+
+  // Binary heap ordered by clock timestamps, storage is reused between deliveries. Cancelled deliveries
+  // stay in the heap until they reach its top or the heap is compacted.
+  std::vector<Delivery> deliveries;
+  uint64_t deliveriesCounter{0};
+
+  // Live deliveries of messages held by the service
+  PendingDeliveries pending;
+
+  // Upper bound of clock timestamps of held messages, exact unless furthestStale is set
+  mutable std::experimental::optional<omnetpp::SimTime> furthest;
+  mutable bool furthestStale{false};
+
+  // The earliest deliveries converted by a single call to IClock::convertToSimulationTimestamps()
+  std::vector<Delivery> batch;
+  std::vector<omnetpp::SimTime> batchClockTimestamps;
+  std::vector<omnetpp::SimTime> batchSimulationTimestamps;
+};
+
+}  // namespace smile
@@ -22,6 +22,7 @@
 #include <omnetpp.h>
 #include <string>
 #include <utility>
+#include "IRangingNicDriver.h"
 #include "IdealRxCompletion_m.h"
 #include "IdealTxCompletion_m.h"
 
@@ -154,5 +155,29 @@ struct Composer<0, IdealTxCompletion>
   }
 };
 
+template <>
+struct Composer<0, IRangingNicDriver::IdealRxCompletionRecord>
+{
+  static std::string compose(std::string buffer, const IRangingNicDriver::IdealRxCompletionRecord& element)
+  {
+    return composeWithBuffer(std::move(buffer), "RX", element.operationBeginClockTimestamp,
+                             element.operationBeginSimulationTimestamp, element.operationBeginTruePosition,
+                             element.operationEndClockTimestamp, element.operationEndSimulationTimestamp,
+                             element.operationEndTruePosition, element.frame->getSrc(), element.frame->getDest());
+  }
+};
+
+template <>
+struct Composer<0, IRangingNicDriver::IdealTxCompletionRecord>
+{
+  static std::string compose(std::string buffer, const IRangingNicDriver::IdealTxCompletionRecord& element)
+  {
+    return composeWithBuffer(std::move(buffer), "TX", element.operationBeginClockTimestamp,
+                             element.operationBeginSimulationTimestamp, element.operationBeginTruePosition,
+                             element.operationEndClockTimestamp, element.operationEndSimulationTimestamp,
+                             element.operationEndTruePosition, element.frame->getSrc(), element.frame->getDest());
+  }
+};
+
 }  // namespace csv_logger
 }  // namespace smile
@@ -0,0 +1,106 @@
+//
+// Copyright (C) 2018 Tomasz Jankowski <t.jankowski AT pwr.edu.pl>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "FastRangingMedium.h"
+#include <algorithm>
+#include <cmath>
+#include "FastRangingNic.h"
+
+namespace smile {
+
+Define_Module(FastRangingMedium);
+
+void FastRangingMedium::registerNic(FastRangingNic* nic)
+{
+  nics.push_back(nic);
+}
+
+void FastRangingMedium::unregisterNic(FastRangingNic* nic)
+{
+  nics.erase(std::remove(nics.begin(), nics.end(), nic), nics.end());
+}
+
+void FastRangingMedium::transmit(const FastRangingNic& transmitter, std::unique_ptr<inet::IdealMacFrame> frame,
+                                 const omnetpp::SimTime& duration)
+{
+  Enter_Method_Silent();
+  take(frame.get());
+
+  const auto id = transmissionsCounter++;
+  auto& transmission = transmissions[id];
+  transmission.id = id;
+  transmission.frame = std::move(frame);
+  transmission.duration = duration;
+
+  const auto transmitterPosition = transmitter.getCurrentPosition();
+  const auto communicationRange = transmitter.getCommunicationRange();
+  const auto communicationRangeSquared = communicationRange * communicationRange;
+  for (auto nic : nics) {
+    if (nic == &transmitter) {
+      continue;
+    }
+
+    // Receivers out of range don't get any event
+    const auto distanceSquared = transmitterPosition.sqrdist(nic->getCurrentPosition());
+    if (distanceSquared > communicationRangeSquared) {
+      continue;
+    }
+
+    const auto propagationDelay = SimTime{std::sqrt(distanceSquared) / propagationSpeed};
+    nic->receive(transmission, propagationDelay);
+    transmission.pendingReceptions++;
+    receptionsCounter++;
+  }
+
+  if (transmission.pendingReceptions == 0) {
+    transmissions.erase(id);
+  }
+}
+
+void FastRangingMedium::releaseTransmission(const Transmission& transmission)
+{
+  const auto entry = transmissions.find(transmission.id);
+  if (entry == transmissions.end()) {
+    throw cRuntimeError{"Released unknown transmission %d", transmission.id};
+  }
+
+  entry->second.pendingReceptions--;
+  if (entry->second.pendingReceptions == 0) {
+    transmissions.erase(entry);
+  }
+}
+
+void FastRangingMedium::initialize()
+{
+  propagationSpeed = par("propagationSpeed");
+  if (propagationSpeed <= 0) {
+    throw cRuntimeError{"Parameter \"propagationSpeed\" has to be positive"};
+  }
+}
+
+void FastRangingMedium::handleMessage(omnetpp::cMessage* message)
+{
+  throw cRuntimeError{"FastRangingMedium does not handle messages, received \"%s\"", message->getFullName()};
+}
+
+void FastRangingMedium::finish()
+{
+  recordScalar("transmissions", transmissionsCounter);
+  recordScalar("receptions", receptionsCounter);
+}
+
+}  // namespace smile
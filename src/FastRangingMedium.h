@@ -0,0 +1,78 @@
+//
+// Copyright (C) 2018 Tomasz Jankowski <t.jankowski AT pwr.edu.pl>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#pragma once
+
+#include <inet/linklayer/ideal/IdealMacFrame_m.h>
+#include <omnetpp.h>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace smile {
+
+class FastRangingNic;
+
+class FastRangingMedium : public omnetpp::cSimpleModule
+{
+ public:
+  // Owned by the medium until all its receptions end, receivers pass copies of the frame to their drivers
+  struct Transmission
+  {
+    int id{-1};
+    std::unique_ptr<const inet::IdealMacFrame> frame;
+    omnetpp::SimTime duration;
+    unsigned int pendingReceptions{0};
+  };
+
+ public:
+  FastRangingMedium() = default;
+  FastRangingMedium(const FastRangingMedium& source) = delete;
+  FastRangingMedium(FastRangingMedium&& source) = delete;
+  ~FastRangingMedium() override = default;
+
+  FastRangingMedium& operator=(const FastRangingMedium& source) = delete;
+  FastRangingMedium& operator=(FastRangingMedium&& source) = delete;
+
+  void registerNic(FastRangingNic* nic);
+
+  void unregisterNic(FastRangingNic* nic);
+
+  // Takes the frame and passes the transmission to all NICs in communication range of the transmitter, receptions
+  // begin after propagation delay computed from current positions
+  void transmit(const FastRangingNic& transmitter, std::unique_ptr<inet::IdealMacFrame> frame,
+                const omnetpp::SimTime& duration);
+
+  // Called by receivers when their reception ends, transmission is deleted after the last one
+  void releaseTransmission(const Transmission& transmission);
+
+ private:
+  void initialize() override;
+
+  void handleMessage(omnetpp::cMessage* message) override;
+
+  void finish() override;
+
+  std::vector<FastRangingNic*> nics;
+  // Transmissions with pending receptions by their IDs, remaining ones are deleted with the medium
+  std::unordered_map<int, Transmission> transmissions;
+  double propagationSpeed{0};
+  int transmissionsCounter{0};
+  unsigned long receptionsCounter{0};
+};
+
+}  // namespace smile
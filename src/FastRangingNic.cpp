@@ -0,0 +1,274 @@
+//
+// Copyright (C) 2018 Tomasz Jankowski <t.jankowski AT pwr.edu.pl>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "FastRangingNic.h"
+#include <inet/common/INETDefs.h>
+#include <inet/common/ModuleAccess.h>
+#include "IdealRangingMac.h"
+#include "utilities.h"
+
+namespace smile {
+
+Define_Module(FastRangingNic);
+
+FastRangingNic::~FastRangingNic()
+{
+  if (transmissionTimer) {
+    cancelEvent(transmissionTimer.get());
+  }
+
+  for (auto& reception : receptions) {
+    cancelEvent(reception->timer.get());
+  }
+
+  // Medium deletes its remaining transmissions if it was deleted first
+  if (mediumId != -1 && getSimulation()->getModule(mediumId)) {
+    for (auto& reception : receptions) {
+      if (reception->transmission) {
+        medium->releaseTransmission(*reception->transmission);
+      }
+    }
+
+    medium->unregisterNic(this);
+  }
+}
+
+void FastRangingNic::setListener(IListener* newListener)
+{
+  listener = newListener;
+}
+
+inet::MACAddress FastRangingNic::getMacAddress() const
+{
+  return address;
+}
+
+inet::Coord FastRangingNic::getCurrentPosition() const
+{
+  return mobility->getCurrentPosition();
+}
+
+double FastRangingNic::getCommunicationRange() const
+{
+  return communicationRange;
+}
+
+void FastRangingNic::transmit(std::unique_ptr<inet::IdealMacFrame> frame)
+{
+  Enter_Method_Silent();
+  take(frame.get());
+
+  if (queue.size() >= queueCapacity) {
+    EV_WARN_C("FastRangingNic") << "Queue is full, frame " << frame->getClassName() << " (ID: " << frame->getId()
+                                << ") dropped" << endl;
+    return;
+  }
+
+  queue.push_back(std::move(frame));
+  if (!transmitting) {
+    startTransmission();
+  }
+}
+
+void FastRangingNic::receive(const FastRangingMedium::Transmission& transmission,
+                             const omnetpp::SimTime& propagationDelay)
+{
+  Enter_Method_Silent();
+  auto& reception = acquireReception();
+  reception.transmission = &transmission;
+  scheduleAt(simTime() + propagationDelay, reception.timer.get());
+}
+
+int FastRangingNic::numInitStages() const
+{
+  return inet::INITSTAGE_LOCAL + 1;
+}
+
+void FastRangingNic::initialize(int stage)
+{
+  if (stage == inet::INITSTAGE_LOCAL) {
+    const auto addressParameter = IdealRangingMac::expandNumericAddress(par("address").stdstringValue());
+    address = addressParameter == "auto" ? inet::MACAddress::generateAutoAddress()
+                                         : inet::MACAddress{addressParameter.c_str()};
+    par("address").setStringValue(address.str());
+
+    bitrate = par("bitrate");
+    if (bitrate <= 0) {
+      throw cRuntimeError{"Parameter \"bitrate\" has to be positive"};
+    }
+
+    communicationRange = par("communicationRange");
+    fullDuplex = par("fullDuplex").boolValue();
+    ignoreInterference = par("ignoreInterference").boolValue();
+    promiscuous = par("promiscuous").boolValue();
+
+    const int capacity = par("queueCapacity");
+    if (capacity < 1) {
+      throw cRuntimeError{"Parameter \"queueCapacity\" has to be positive"};
+    }
+    queueCapacity = capacity;
+
+    mobility = inet::getModuleFromPar<inet::IMobility>(par("mobilityModule"), this, true);
+    medium = inet::getModuleFromPar<FastRangingMedium>(par("radioMediumModule"), this, true);
+    medium->registerNic(this);
+    mediumId = medium->getId();
+
+    transmissionTimer = std::make_unique<cMessage>("transmissionTimer");
+  }
+}
+
+void FastRangingNic::handleMessage(omnetpp::cMessage* message)
+{
+  handledEventsCounter++;
+  if (message == transmissionTimer.get()) {
+    endTransmission();
+  }
+  else if (message->isSelfMessage()) {
+    auto& reception = *static_cast<Reception*>(message->getContextPointer());
+    if (reception.started) {
+      endReception(reception);
+    }
+    else {
+      beginReception(reception);
+    }
+  }
+  else if (message->arrivedOn("upperLayerIn")) {
+    transmit(dynamic_unique_ptr_cast<inet::IdealMacFrame>(std::unique_ptr<cMessage>{message}));
+  }
+  else {
+    std::unique_ptr<cMessage> unexpectedMessage{message};
+    throw cRuntimeError{"Received unexpected message \"%s\" on gate \"%s\"", unexpectedMessage->getFullName(),
+                        unexpectedMessage->getArrivalGate()->getFullName()};
+  }
+}
+
+void FastRangingNic::finish()
+{
+  recordScalar("handledEvents", handledEventsCounter);
+}
+
+void FastRangingNic::startTransmission()
+{
+  auto frame = std::move(queue.front());
+  queue.pop_front();
+
+  const auto duration = SimTime{frame->getBitLength() / bitrate};
+  transmitting = true;
+  if (!fullDuplex && currentReception) {
+    currentReception->interfered = true;
+  }
+
+  EV_DETAIL_C("FastRangingNic") << "Transmission of frame " << frame->getClassName() << " (ID: " << frame->getId()
+                                << ") started, duration: " << duration << endl;
+
+  if (listener) {
+    listener->handleTransmissionStarted();
+  }
+
+  medium->transmit(*this, std::move(frame), duration);
+  scheduleAt(simTime() + duration, transmissionTimer.get());
+}
+
+void FastRangingNic::endTransmission()
+{
+  transmitting = false;
+  if (listener) {
+    listener->handleTransmissionEnded();
+  }
+
+  if (!queue.empty()) {
+    startTransmission();
+  }
+}
+
+void FastRangingNic::beginReception(Reception& reception)
+{
+  reception.started = true;
+  scheduleAt(simTime() + reception.transmission->duration, reception.timer.get());
+
+  if ((transmitting && !fullDuplex) || currentReception) {
+    if (currentReception && !ignoreInterference) {
+      currentReception->interfered = true;
+    }
+
+    EV_DETAIL_C("FastRangingNic") << "Reception of transmission " << reception.transmission->id << " ignored" << endl;
+    return;
+  }
+
+  currentReception = &reception;
+  if (listener) {
+    listener->handleReceptionStarted(reception.transmission->id);
+  }
+}
+
+void FastRangingNic::endReception(Reception& reception)
+{
+  if (&reception == currentReception) {
+    currentReception = nullptr;
+    if (listener) {
+      listener->handleReceptionEnded(reception.transmission->id);
+    }
+
+    const auto& frame = *reception.transmission->frame;
+    if (reception.interfered) {
+      EV_DETAIL_C("FastRangingNic") << "Frame " << frame.getClassName() << " (ID: " << frame.getId()
+                                    << ") dropped due to interference" << endl;
+    }
+    else if (isAddressedToNic(frame)) {
+      std::unique_ptr<inet::IdealMacFrame> receivedFrame{frame.dup()};
+      if (listener) {
+        listener->handleFrameReceived(std::move(receivedFrame));
+      }
+      else {
+        send(receivedFrame.release(), "upperLayerOut");
+      }
+    }
+  }
+
+  releaseReception(reception);
+}
+
+bool FastRangingNic::isAddressedToNic(const inet::IdealMacFrame& frame) const
+{
+  return promiscuous || frame.getDest().isBroadcast() || frame.getDest() == address;
+}
+
+FastRangingNic::Reception& FastRangingNic::acquireReception()
+{
+  if (freeReceptions.empty()) {
+    auto reception = std::make_unique<Reception>();
+    reception->timer = std::make_unique<cMessage>("receptionTimer");
+    reception->timer->setContextPointer(reception.get());
+    freeReceptions.push_back(reception.get());
+    receptions.push_back(std::move(reception));
+  }
+
+  auto& reception = *freeReceptions.back();
+  freeReceptions.pop_back();
+  reception.started = false;
+  reception.interfered = false;
+  return reception;
+}
+
+void FastRangingNic::releaseReception(Reception& reception)
+{
+  medium->releaseTransmission(*reception.transmission);
+  reception.transmission = nullptr;
+  freeReceptions.push_back(&reception);
+}
+
+}  // namespace smile
@@ -0,0 +1,136 @@
+//
+// Copyright (C) 2018 Tomasz Jankowski <t.jankowski AT pwr.edu.pl>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#pragma once
+
+#include <inet/common/geometry/common/Coord.h>
+#include <inet/linklayer/common/MACAddress.h>
+#include <inet/linklayer/ideal/IdealMacFrame_m.h>
+#include <inet/mobility/contract/IMobility.h>
+#include <omnetpp.h>
+#include <deque>
+#include <memory>
+#include <vector>
+#include "FastRangingMedium.h"
+
+namespace smile {
+
+// Wireless NIC which bypasses INET queue, MAC and radio modules. Transmissions are passed to FastRangingMedium,
+// receptions are reported directly to the listener (usually IdealRangingNicDriver).
+class FastRangingNic : public omnetpp::cSimpleModule
+{
+ public:
+  class IListener
+  {
+   public:
+    virtual ~IListener() = default;
+
+    // Called in context of the NIC
+    virtual void handleTransmissionStarted() = 0;
+
+    virtual void handleTransmissionEnded() = 0;
+
+    virtual void handleReceptionStarted(int transmissionId) = 0;
+
+    virtual void handleReceptionEnded(int transmissionId) = 0;
+
+    // Called after handleReceptionEnded() if frame was received successfully and is addressed to the NIC
+    virtual void handleFrameReceived(std::unique_ptr<inet::IdealMacFrame> frame) = 0;
+  };
+
+ public:
+  FastRangingNic() = default;
+  FastRangingNic(const FastRangingNic& source) = delete;
+  FastRangingNic(FastRangingNic&& source) = delete;
+  ~FastRangingNic() override;
+
+  FastRangingNic& operator=(const FastRangingNic& source) = delete;
+  FastRangingNic& operator=(FastRangingNic&& source) = delete;
+
+  // Without listener received frames are sent through upperLayerOut gate
+  void setListener(IListener* newListener);
+
+  inet::MACAddress getMacAddress() const;
+
+  inet::Coord getCurrentPosition() const;
+
+  double getCommunicationRange() const;
+
+  // Frames are queued while transmission is in progress
+  void transmit(std::unique_ptr<inet::IdealMacFrame> frame);
+
+  // Called by the medium, reception begins after propagation delay and the transmission is released when it ends
+  void receive(const FastRangingMedium::Transmission& transmission, const omnetpp::SimTime& propagationDelay);
+
+ private:
+  struct Reception
+  {
+    const FastRangingMedium::Transmission* transmission{nullptr};
+    bool started{false};
+    bool interfered{false};
+    // Scheduled at the beginning and then at the end of reception, context pointer refers to the reception
+    std::unique_ptr<omnetpp::cMessage> timer;
+  };
+
+  int numInitStages() const override;
+
+  void initialize(int stage) override;
+
+  void handleMessage(omnetpp::cMessage* message) override;
+
+  void finish() override;
+
+  void startTransmission();
+
+  void endTransmission();
+
+  void beginReception(Reception& reception);
+
+  void endReception(Reception& reception);
+
+  bool isAddressedToNic(const inet::IdealMacFrame& frame) const;
+
+  // Receptions are reused, so steady state doesn't allocate timers
+  Reception& acquireReception();
+
+  void releaseReception(Reception& reception);
+
+  FastRangingMedium* medium{nullptr};
+  // Medium may be deleted before the NIC at the end of simulation, so it's looked up by ID in the destructor
+  int mediumId{-1};
+  inet::IMobility* mobility{nullptr};
+  IListener* listener{nullptr};
+  inet::MACAddress address;
+  double bitrate{0};
+  double communicationRange{0};
+  bool fullDuplex{true};
+  bool ignoreInterference{false};
+  bool promiscuous{false};
+  size_t queueCapacity{0};
+
+  std::deque<std::unique_ptr<inet::IdealMacFrame>> queue;
+  std::unique_ptr<omnetpp::cMessage> transmissionTimer;
+  bool transmitting{false};
+
+  std::vector<std::unique_ptr<Reception>> receptions;
+  std::vector<Reception*> freeReceptions;
+  // Reception passed to the listener, other receptions overlapping with it are not received
+  Reception* currentReception{nullptr};
+  unsigned long handledEventsCounter{0};
+};
+
+}  // namespace smile
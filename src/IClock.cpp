@@ -21,4 +21,14 @@ namespace smile {
 
 const omnetpp::simsignal_t IClock::windowUpdateSignal{omnetpp::cComponent::registerSignal("windowUpdate")};
 
+std::shared_ptr<ClockTimerService> IClock::getTimerService() const
+{
+  return timerService;
+}
+
+void IClock::releaseTimers()
+{
+  timerService->release(*this);
+}
+
 }  // namespace smile
@@ -19,6 +19,9 @@
 
 #include <omnetpp.h>
 #include <experimental/optional>
+#include <memory>
+#include <vector>
+#include "ClockTimerService.h"
 
 namespace smile {
 
@@ -38,10 +41,24 @@ class IClock
   virtual omnetpp::SimTime getClockTimestamp() = 0;
   virtual OptionalSimTime convertToSimulationTimestamp(const omnetpp::SimTime& timestamp) = 0;
 
+  // Converts timestamps sorted in ascending order up to the first one that can't be converted, returns number of
+  // converted timestamps. simulationTimestamps is replaced with the results.
+  virtual size_t convertToSimulationTimestamps(const std::vector<omnetpp::SimTime>& timestamps,
+                                               std::vector<omnetpp::SimTime>& simulationTimestamps) = 0;
+
+  // Returns service holding messages of modules using the clock, shared so the service outlives the clock module
+  std::shared_ptr<ClockTimerService> getTimerService() const;
+
   static const omnetpp::simsignal_t windowUpdateSignal;
 
  protected:
   IClock() = default;
+
+  // Has to be called by implementations after conversion window advances
+  void releaseTimers();
+
+ private:
+  std::shared_ptr<ClockTimerService> timerService{std::make_shared<ClockTimerService>()};
 };
 
 }  // namespace smile
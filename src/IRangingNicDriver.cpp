@@ -16,10 +16,62 @@
 //
 
 #include "IRangingNicDriver.h"
+#include "IdealRxCompletion_m.h"
+#include "IdealTxCompletion_m.h"
 
 namespace smile {
 
+namespace {
+
+template <typename Record, typename Object>
+void copyRecordToObject(const Record& source, Object& destination)
+{
+  destination.setStatus(source.status);
+  destination.setFrame(source.frame);
+  destination.setOperationBeginClockTimestamp(source.operationBeginClockTimestamp);
+  destination.setOperationBeginSimulationTimestamp(source.operationBeginSimulationTimestamp);
+  destination.setOperationEndClockTimestamp(source.operationEndClockTimestamp);
+  destination.setOperationEndSimulationTimestamp(source.operationEndSimulationTimestamp);
+  destination.setOperationBeginTruePosition(source.operationBeginTruePosition);
+  destination.setOperationEndTruePosition(source.operationEndTruePosition);
+}
+
+template <typename Object, typename Record>
+void copyObjectToRecord(const Object& source, Record& destination)
+{
+  destination.status = source.getStatus();
+  destination.frame = source.getFrame();
+  destination.operationBeginClockTimestamp = source.getOperationBeginClockTimestamp();
+  destination.operationBeginSimulationTimestamp = source.getOperationBeginSimulationTimestamp();
+  destination.operationEndClockTimestamp = source.getOperationEndClockTimestamp();
+  destination.operationEndSimulationTimestamp = source.getOperationEndSimulationTimestamp();
+  destination.operationBeginTruePosition = source.getOperationBeginTruePosition();
+  destination.operationEndTruePosition = source.getOperationEndTruePosition();
+}
+
+}  // namespace
+
 const omnetpp::simsignal_t IRangingNicDriver::txCompletedSignalId = omnetpp::cComponent::registerSignal("txCompleted");
 const omnetpp::simsignal_t IRangingNicDriver::rxCompletedSignalId = omnetpp::cComponent::registerSignal("rxCompleted");
 
+void IRangingNicDriver::copyCompletion(const IdealTxCompletionRecord& source, IdealTxCompletion& destination)
+{
+  copyRecordToObject(source, destination);
+}
+
+void IRangingNicDriver::copyCompletion(const IdealTxCompletion& source, IdealTxCompletionRecord& destination)
+{
+  copyObjectToRecord(source, destination);
+}
+
+void IRangingNicDriver::copyCompletion(const IdealRxCompletionRecord& source, IdealRxCompletion& destination)
+{
+  copyRecordToObject(source, destination);
+}
+
+void IRangingNicDriver::copyCompletion(const IdealRxCompletion& source, IdealRxCompletionRecord& destination)
+{
+  copyObjectToRecord(source, destination);
+}
+
 }  // namespace smile
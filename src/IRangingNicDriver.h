@@ -17,11 +17,21 @@
 
 #pragma once
 
+#include <inet/common/geometry/common/Coord.h>
 #include <inet/linklayer/common/MACAddress.h>
 #include <omnetpp.h>
 
+namespace inet {
+
+class IdealMacFrame;
+
+}  // namespace inet
+
 namespace smile {
 
+class IdealTxCompletion;
+class IdealRxCompletion;
+
 class IRangingNicDriver
 {
  public:
@@ -35,6 +45,42 @@ class IRangingNicDriver
     SUCCESS
   };
 
+  // Plain completion records, frame pointers have the same lifetime as in IdealTxCompletion and IdealRxCompletion
+  struct IdealTxCompletionRecord
+  {
+    IdealTxCompletionStatus status{IdealTxCompletionStatus::SUCCESS};
+    const inet::IdealMacFrame* frame{nullptr};
+    omnetpp::SimTime operationBeginClockTimestamp;
+    omnetpp::SimTime operationBeginSimulationTimestamp;
+    omnetpp::SimTime operationEndClockTimestamp;
+    omnetpp::SimTime operationEndSimulationTimestamp;
+    inet::Coord operationBeginTruePosition;
+    inet::Coord operationEndTruePosition;
+  };
+
+  struct IdealRxCompletionRecord
+  {
+    IdealRxCompletionStatus status{IdealRxCompletionStatus::SUCCESS};
+    const inet::IdealMacFrame* frame{nullptr};
+    omnetpp::SimTime operationBeginClockTimestamp;
+    omnetpp::SimTime operationBeginSimulationTimestamp;
+    omnetpp::SimTime operationEndClockTimestamp;
+    omnetpp::SimTime operationEndSimulationTimestamp;
+    inet::Coord operationBeginTruePosition;
+    inet::Coord operationEndTruePosition;
+  };
+
+  class ICompletionListener
+  {
+   public:
+    virtual ~ICompletionListener() = default;
+
+    // Called in context of the driver
+    virtual void handleTxCompletion(const IdealTxCompletionRecord& completion) = 0;
+
+    virtual void handleRxCompletion(const IdealRxCompletionRecord& completion) = 0;
+  };
+
  public:
   IRangingNicDriver(const IRangingNicDriver& source) = delete;
   IRangingNicDriver(IRangingNicDriver&& source) = delete;
@@ -46,8 +92,23 @@ class IRangingNicDriver
   static const simsignal_t txCompletedSignalId;
   static const simsignal_t rxCompletedSignalId;
 
+  // Copy completions between records and objects carried by txCompleted and rxCompleted signals
+  static void copyCompletion(const IdealTxCompletionRecord& source, IdealTxCompletion& destination);
+
+  static void copyCompletion(const IdealTxCompletion& source, IdealTxCompletionRecord& destination);
+
+  static void copyCompletion(const IdealRxCompletionRecord& source, IdealRxCompletion& destination);
+
+  static void copyCompletion(const IdealRxCompletion& source, IdealRxCompletionRecord& destination);
+
   virtual inet::MACAddress getMacAddress() const = 0;
 
+  // Listeners are called directly, in order of registration, before txCompleted and rxCompleted signals are emitted.
+  // Signals carry IdealTxCompletion and IdealRxCompletion objects and are emitted only if they have listeners.
+  virtual void addCompletionListener(ICompletionListener* listener) = 0;
+
+  virtual void removeCompletionListener(ICompletionListener* listener) = 0;
+
  protected:
   IRangingNicDriver() = default;
 };
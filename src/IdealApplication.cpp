@@ -26,21 +26,73 @@ namespace smile {
 
 Define_Module(IdealApplication);
 
+IdealApplication::~IdealApplication()
+{
+  if (completionListenerDriverId == -1) {
+    return;
+  }
+
+  // Driver may be deleted before the application at the end of simulation
+  auto nicDriverModule = getSimulation()->getModule(completionListenerDriverId);
+  if (nicDriverModule) {
+    check_and_cast<IRangingNicDriver*>(nicDriverModule)->removeCompletionListener(this);
+  }
+}
+
 void IdealApplication::initialize(int stage)
 {
   Application::initialize(stage);
   if (stage == inet::INITSTAGE_LOCAL) {
-    auto nicDriverModule = check_and_cast<cModule*>(&getNicDriver());
-    nicDriverModule->subscribe(IRangingNicDriver::txCompletedSignalId, this);
-    nicDriverModule->subscribe(IRangingNicDriver::rxCompletedSignalId, this);
+    const int poolSize = par("framePoolSize");
+    if (poolSize < 0) {
+      throw cRuntimeError{"Parameter \"framePoolSize\" can't be negative"};
+    }
+    framePoolSize = poolSize;
+
+    if (par("completionSignals").boolValue()) {
+      auto nicDriverModule = check_and_cast<cModule*>(&getNicDriver());
+      nicDriverModule->subscribe(IRangingNicDriver::txCompletedSignalId, this);
+      nicDriverModule->subscribe(IRangingNicDriver::rxCompletedSignalId, this);
+    }
+    else {
+      getNicDriver().addCompletionListener(this);
+      completionListenerDriverId = check_and_cast<cModule*>(&getNicDriver())->getId();
+    }
   }
 
   if (stage == inet::INITSTAGE_LINK_LAYER_2) {
+    // Address is parsed once, frames are created with the cached one
     const auto& nicDriver = getNicDriver();
     macAddress = nicDriver.getMacAddress();
   }
 }
 
+void IdealApplication::finish()
+{
+  Application::finish();
+
+  recordScalar("framesAllocated", framesAllocated);
+  recordScalar("framesReused", framesReused);
+  recordScalar("frameControlInformationAllocated", controlInformationAllocated);
+
+  EV_INFO_C("IdealApplication") << "Frames allocated: " << framesAllocated << ", reused: " << framesReused << endl;
+}
+
+void IdealApplication::recycleFrame(std::unique_ptr<inet::IdealMacFrame> frame)
+{
+  std::unique_ptr<cObject> controlInformation{frame->removeControlInfo()};
+  auto ieee802ControlInformation = dynamic_cast<inet::Ieee802Ctrl*>(controlInformation.get());
+  if (ieee802ControlInformation && recycledControlInformation.size() < framePoolSize) {
+    controlInformation.release();
+    recycledControlInformation.emplace_back(ieee802ControlInformation);
+  }
+
+  auto& pool = recycledFrames[typeid(*frame)];
+  if (pool.size() < framePoolSize) {
+    pool.push_back(std::move(frame));
+  }
+}
+
 void IdealApplication::handleTxCompletionSignal(const IdealTxCompletion&)
 {
   EV_WARN_C("IdealApplication") << "Dummy handler handleTxCompletionSignal() was called" << endl;
@@ -51,19 +103,50 @@ void IdealApplication::handleRxCompletionSignal(const IdealRxCompletion&)
   EV_WARN_C("IdealApplication") << "Dummy handler handleRxCompletionSignal() was called" << endl;
 }
 
+void IdealApplication::handleTxCompletionRecord(const TxCompletion& completion)
+{
+  IRangingNicDriver::copyCompletion(completion, txCompletionObject);
+  handleTxCompletionSignal(txCompletionObject);
+}
+
+void IdealApplication::handleRxCompletionRecord(const RxCompletion& completion)
+{
+  IRangingNicDriver::copyCompletion(completion, rxCompletionObject);
+  handleRxCompletionSignal(rxCompletionObject);
+}
+
+void IdealApplication::nextTxCompletion(TxCompletionContinuation continuation)
+{
+  txCompletionContinuations.push_back(std::move(continuation));
+}
+
+void IdealApplication::nextRxCompletion(RxCompletionContinuation continuation)
+{
+  rxCompletionContinuations.push_back(std::move(continuation));
+}
+
 const inet::MACAddress& IdealApplication::getMacAddress() const
 {
   return macAddress;
 }
 
-void IdealApplication::initializeFrame(inet::IdealMacFrame& frame, const inet::MACAddress& destinationAddress,
-                                       const inet::MACAddress& sourceAddress)
+void IdealApplication::initializeFrame(inet::IdealMacFrame& frame, const inet::MACAddress& destinationAddress)
 {
-  auto controlInformation = std::make_unique<inet::Ieee802Ctrl>();
-  controlInformation->setSourceAddress(sourceAddress);
+  std::unique_ptr<inet::Ieee802Ctrl> controlInformation;
+  if (recycledControlInformation.empty()) {
+    controlInformation = std::make_unique<inet::Ieee802Ctrl>();
+    controlInformationAllocated++;
+  }
+  else {
+    controlInformation = std::move(recycledControlInformation.back());
+    recycledControlInformation.pop_back();
+    *controlInformation = inet::Ieee802Ctrl{};
+  }
+
+  controlInformation->setSourceAddress(macAddress);
   controlInformation->setDest(destinationAddress);
 
-  frame.setSrc(sourceAddress);
+  frame.setSrc(macAddress);
   frame.setDest(destinationAddress);
   frame.setControlInfo(controlInformation.release());
 }
@@ -71,17 +154,75 @@ void IdealApplication::initializeFrame(inet::IdealMacFrame& frame, const inet::M
 void IdealApplication::receiveSignal(omnetpp::cComponent* source, omnetpp::simsignal_t signalID, cObject* value,
                                      omnetpp::cObject* details)
 {
+  // Signals are emitted in context of the driver, continuations and handlers create frames and timers of their own
+  Enter_Method_Silent();
   if (signalID == IRangingNicDriver::txCompletedSignalId) {
-    auto completion = check_and_cast<const IdealTxCompletion*>(value);
-    handleTxCompletionSignal(*completion);
+    const auto& object = *check_and_cast<const IdealTxCompletion*>(value);
+    if (txCompletionContinuations.empty()) {
+      handleTxCompletionSignal(object);
+    }
+    else {
+      TxCompletion completion;
+      IRangingNicDriver::copyCompletion(object, completion);
+      runTxCompletionContinuations(completion);
+    }
   }
   else if (signalID == IRangingNicDriver::rxCompletedSignalId) {
-    auto completion = check_and_cast<const IdealRxCompletion*>(value);
-    handleRxCompletionSignal(*completion);
+    const auto& object = *check_and_cast<const IdealRxCompletion*>(value);
+    if (rxCompletionContinuations.empty()) {
+      handleRxCompletionSignal(object);
+    }
+    else {
+      RxCompletion completion;
+      IRangingNicDriver::copyCompletion(object, completion);
+      runRxCompletionContinuations(completion);
+    }
   }
   else {
     throw cRuntimeError{"Received unexpected signal \"%s\"", getSignalName(signalID)};
   }
 }
 
+void IdealApplication::handleTxCompletion(const TxCompletion& completion)
+{
+  Enter_Method_Silent();
+  if (txCompletionContinuations.empty()) {
+    handleTxCompletionRecord(completion);
+  }
+  else {
+    runTxCompletionContinuations(completion);
+  }
+}
+
+void IdealApplication::handleRxCompletion(const RxCompletion& completion)
+{
+  Enter_Method_Silent();
+  if (rxCompletionContinuations.empty()) {
+    handleRxCompletionRecord(completion);
+  }
+  else {
+    runRxCompletionContinuations(completion);
+  }
+}
+
+void IdealApplication::runTxCompletionContinuations(const TxCompletion& completion)
+{
+  // Continuations may wait for the next completion again
+  std::vector<TxCompletionContinuation> continuations;
+  continuations.swap(txCompletionContinuations);
+  for (auto& continuation : continuations) {
+    continuation(completion);
+  }
+}
+
+void IdealApplication::runRxCompletionContinuations(const RxCompletion& completion)
+{
+  // Continuations may wait for the next completion again
+  std::vector<RxCompletionContinuation> continuations;
+  continuations.swap(rxCompletionContinuations);
+  for (auto& continuation : continuations) {
+    continuation(completion);
+  }
+}
+
 }  // namespace smile
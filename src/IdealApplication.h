@@ -18,23 +18,29 @@
 #pragma once
 
 #include <inet/common/geometry/common/Coord.h>
+#include <inet/linklayer/common/Ieee802Ctrl.h>
 #include <inet/linklayer/ideal/IdealMacFrame_m.h>
 #include <omnetpp.h>
+#include <functional>
 #include <memory>
+#include <new>
 #include <type_traits>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
 #include "Application.h"
 #include "IdealRxCompletion_m.h"
 #include "IdealTxCompletion_m.h"
 
 namespace smile {
 
-class IdealApplication : public Application
+class IdealApplication : public Application, private IRangingNicDriver::ICompletionListener
 {
  public:
   IdealApplication() = default;
   IdealApplication(const IdealApplication& source) = delete;
   IdealApplication(IdealApplication&& source) = delete;
-  ~IdealApplication() = default;
+  ~IdealApplication();
 
   IdealApplication& operator=(const IdealApplication& source) = delete;
   IdealApplication& operator=(IdealApplication&& source) = delete;
@@ -44,23 +50,71 @@ class IdealApplication : public Application
 
   void initialize(int stage) override;
 
+  // Records statistics of the frame pool
+  void finish() override;
+
+  // Returns initialized frame, recycled frames of the same type are reused
   template <typename Frame, typename... FrameArguments>
   std::unique_ptr<Frame> createFrame(const inet::MACAddress& destinationAddress, FrameArguments&&... frameArguments);
 
+  // Keeps frame (e.g. received one that was already handled) and its control information for reuse by createFrame()
+  void recycleFrame(std::unique_ptr<inet::IdealMacFrame> frame);
+
+  using TxCompletion = IRangingNicDriver::IdealTxCompletionRecord;
+  using RxCompletion = IRangingNicDriver::IdealRxCompletionRecord;
+
+  // Called for completions emitted by the driver as signals, i.e. if "completionSignals" parameter is set
   virtual void handleTxCompletionSignal(const IdealTxCompletion& completion);
 
   virtual void handleRxCompletionSignal(const IdealRxCompletion& completion);
 
+  // Called for completions passed by the driver directly. By default completion is copied to an object and passed to
+  // the signal handler, so applications which override only the signal handlers work in both modes.
+  virtual void handleTxCompletionRecord(const TxCompletion& completion);
+
+  virtual void handleRxCompletionRecord(const RxCompletion& completion);
+
+  using TxCompletionContinuation = std::function<void(const TxCompletion&)>;
+  using RxCompletionContinuation = std::function<void(const RxCompletion&)>;
+
+  // Passes the next completion to continuation instead of the handler
+  void nextTxCompletion(TxCompletionContinuation continuation);
+
+  // Passes the next completion to continuation instead of the handler
+  void nextRxCompletion(RxCompletionContinuation continuation);
+
   const inet::MACAddress& getMacAddress() const;
 
  private:
-  static void initializeFrame(inet::IdealMacFrame& frame, const inet::MACAddress& destinationAddress,
-                              const inet::MACAddress& sourceAddress);
+  void initializeFrame(inet::IdealMacFrame& frame, const inet::MACAddress& destinationAddress);
 
   void receiveSignal(omnetpp::cComponent* source, omnetpp::simsignal_t signalID, cObject* value,
                      omnetpp::cObject* details) override;
 
+  // Passes completion to continuations or to the record handler
+  void handleTxCompletion(const TxCompletion& completion) override;
+
+  void handleRxCompletion(const RxCompletion& completion) override;
+
+  void runTxCompletionContinuations(const TxCompletion& completion);
+
+  void runRxCompletionContinuations(const RxCompletion& completion);
+
   inet::MACAddress macAddress;
+  // ID of the driver module the application is registered with as completion listener, -1 if it isn't
+  int completionListenerDriverId{-1};
+  IdealTxCompletion txCompletionObject;
+  IdealRxCompletion rxCompletionObject;
+
+  // Recycled frames by their exact types, each pool is limited to framePoolSize frames
+  std::unordered_map<std::type_index, std::vector<std::unique_ptr<inet::IdealMacFrame>>> recycledFrames;
+  std::vector<std::unique_ptr<inet::Ieee802Ctrl>> recycledControlInformation;
+  size_t framePoolSize{0};
+  unsigned long framesAllocated{0};
+  unsigned long framesReused{0};
+  unsigned long controlInformationAllocated{0};
+  std::vector<TxCompletionContinuation> txCompletionContinuations;
+  std::vector<RxCompletionContinuation> rxCompletionContinuations;
 };
 
 template <typename Frame, typename... FrameArguments>
@@ -71,10 +125,22 @@ std::unique_ptr<Frame> IdealApplication::createFrame(const inet::MACAddress& des
   constexpr auto isSame = std::is_same<inet::IdealMacFrame, Frame>::value;
   static_assert(isDerived || isSame, "IdealApplication::createFrame requires Frame to derive from inet::IdealMacFrame");
 
-  auto frame = std::make_unique<Frame>(std::forward<FrameArguments>(frameArguments)...);
-  const auto& nicDriver = getNicDriver();
-  const auto localAddress = nicDriver.getMacAddress();
-  initializeFrame(*frame, destinationAddress, localAddress);
+  std::unique_ptr<Frame> frame;
+  auto& pool = recycledFrames[typeid(Frame)];
+  if (pool.empty()) {
+    frame = std::make_unique<Frame>(std::forward<FrameArguments>(frameArguments)...);
+    framesAllocated++;
+  }
+  else {
+    // Recycled frame is constructed again in place, so it gets a new message ID as an allocated one would
+    auto recycledFrame = static_cast<Frame*>(pool.back().release());
+    pool.pop_back();
+    recycledFrame->~Frame();
+    frame.reset(new (recycledFrame) Frame(std::forward<FrameArguments>(frameArguments)...));
+    framesReused++;
+  }
+
+  initializeFrame(*frame, destinationAddress);
   return frame;
 }
 
@@ -32,4 +32,11 @@ IdealClock::OptionalSimTime IdealClock::convertToSimulationTimestamp(const SimTi
   return timestamp;
 }
 
+size_t IdealClock::convertToSimulationTimestamps(const std::vector<SimTime>& timestamps,
+                                                 std::vector<SimTime>& simulationTimestamps)
+{
+  simulationTimestamps = timestamps;
+  return timestamps.size();
+}
+
 }  // namespace smile
@@ -34,6 +34,8 @@ class IdealClock : public Clock
 
   omnetpp::SimTime getClockTimestamp() override;
   OptionalSimTime convertToSimulationTimestamp(const omnetpp::SimTime& timestamp) override;
+  size_t convertToSimulationTimestamps(const std::vector<omnetpp::SimTime>& timestamps,
+                                       std::vector<omnetpp::SimTime>& simulationTimestamps) override;
 };
 
 }  // namespace smile
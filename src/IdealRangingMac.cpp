@@ -21,17 +21,22 @@ namespace smile {
 
 Define_Module(IdealRangingMac);
 
-void IdealRangingMac::initializeMACAddress()
+std::string IdealRangingMac::expandNumericAddress(const std::string& address)
 {
-  const auto address = par("address").stdstringValue();
   const auto isInteger = [&address] { return address.find_first_not_of("0123456789") == std::string::npos; };
 
   if (isInteger()) {
     const uint64_t numericAddress = 0xCCAA00000000 + std::stol(address);
     const auto macAddress = inet::MACAddress{numericAddress};
-    par("address").setStringValue(macAddress.str());
+    return macAddress.str();
   }
 
+  return address;
+}
+
+void IdealRangingMac::initializeMACAddress()
+{
+  par("address").setStringValue(expandNumericAddress(par("address").stdstringValue()));
   IdealMac::initializeMACAddress();
 }
 
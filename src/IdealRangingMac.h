@@ -19,6 +19,7 @@
 
 #include <inet/linklayer/ideal/IdealMac.h>
 #include <omnetpp.h>
+#include <string>
 
 namespace smile {
 
@@ -33,6 +34,9 @@ class IdealRangingMac : public inet::IdealMac
   IdealRangingMac& operator=(const IdealRangingMac& source) = delete;
   IdealRangingMac& operator=(IdealRangingMac&& source) = delete;
 
+  // Returns integer addresses expanded to MAC addresses with CC-AA prefix, other addresses are returned unchanged
+  static std::string expandNumericAddress(const std::string& address);
+
  private:
   void initializeMACAddress() override;
 };
@@ -16,6 +16,8 @@
 //
 
 #include "IdealRangingNicDriver.h"
+#include <algorithm>
+#include <typeinfo>
 #include "utilities.h"
 
 namespace smile {
@@ -24,9 +26,26 @@ Define_Module(IdealRangingNicDriver);
 
 inet::MACAddress IdealRangingNicDriver::getMacAddress() const
 {
+  if (fastNic) {
+    return fastNic->getMacAddress();
+  }
+
   return inet::MACAddress{mac->par("address").stringValue()};
 }
 
+void IdealRangingNicDriver::addCompletionListener(ICompletionListener* listener)
+{
+  completionListeners.push_back(listener);
+}
+
+void IdealRangingNicDriver::removeCompletionListener(ICompletionListener* listener)
+{
+  const auto position = std::find(completionListeners.begin(), completionListeners.end(), listener);
+  if (position != completionListeners.end()) {
+    completionListeners.erase(position);
+  }
+}
+
 void IdealRangingNicDriver::initialize(int stage)
 {
   ClockDecorator<cSimpleModule>::initialize(stage);
@@ -38,24 +57,36 @@ void IdealRangingNicDriver::initialize(int stage)
       throw cRuntimeError{"Failed to find \"%s\" module", nicModulePath};
     }
 
-    const auto radioModulePath = ".radio";
-    auto radioModule = nic->getModuleByPath(radioModulePath);
-    if (!radioModule) {
-      throw cRuntimeError{"Failed to find \"%s\" module relative to \"nic\" module", radioModulePath};
+    fastNic = dynamic_cast<FastRangingNic*>(nic);
+    if (fastNic) {
+      fastNic->setListener(this);
     }
+    else {
+      const auto radioModulePath = ".radio";
+      auto radioModule = nic->getModuleByPath(radioModulePath);
+      if (!radioModule) {
+        throw cRuntimeError{"Failed to find \"%s\" module relative to \"nic\" module", radioModulePath};
+      }
 
-    radio = check_and_cast<inet::physicallayer::IRadio*>(radioModule);
-    radioModule->subscribe(inet::physicallayer::IRadio::transmissionStateChangedSignal, this);
-    radioModule->subscribe(inet::physicallayer::IRadio::receptionStateChangedSignal, this);
+      radio = check_and_cast<inet::physicallayer::IRadio*>(radioModule);
+      radioModule->subscribe(inet::physicallayer::IRadio::transmissionStateChangedSignal, this);
+      radioModule->subscribe(inet::physicallayer::IRadio::receptionStateChangedSignal, this);
 
-    const auto macModulePath = ".mac";
-    mac = nic->getModuleByPath(macModulePath);
-    if (!mac) {
-      throw cRuntimeError{"Failed to find \"%s\" module relative to \"nic\" module", macModulePath};
+      const auto macModulePath = ".mac";
+      mac = nic->getModuleByPath(macModulePath);
+      if (!mac) {
+        throw cRuntimeError{"Failed to find \"%s\" module relative to \"nic\" module", macModulePath};
+      }
     }
 
     const auto mobilityPath = par("mobilityModule").stringValue();
     mobility = check_and_cast<inet::IMobility*>(getModuleByPath(mobilityPath));
+
+    const int maxConcurrentReceptions = par("maxConcurrentReceptions");
+    if (maxConcurrentReceptions < 1) {
+      throw cRuntimeError{"Parameter \"maxConcurrentReceptions\" has to be positive"};
+    }
+    receptions.resize(maxConcurrentReceptions);
   }
 }
 
@@ -90,24 +121,51 @@ void IdealRangingNicDriver::receiveSignal(omnetpp::cComponent* source, omnetpp::
 
 void IdealRangingNicDriver::handleApplicationIn(std::unique_ptr<inet::IdealMacFrame> frame)
 {
-  txFrame.reset(frame->dup());
-  txCompletion.setFrame(txFrame.get());
-  send(frame.release(), "nicOut");
+  snapshotTxFrame(*frame);
+  txCompletion.frame = txFrame.get();
+  if (fastNic) {
+    fastNic->transmit(std::move(frame));
+  }
+  else {
+    send(frame.release(), "nicOut");
+  }
 }
 
 void IdealRangingNicDriver::handleNicIn(std::unique_ptr<inet::IdealMacFrame> frame)
 {
-  rxFrame.reset(frame->dup());
-  rxCompletion.setFrame(rxFrame.get());
+  auto& reception = findCompletedReception();
+  rxCompletion.operationBeginClockTimestamp = reception.beginClockTimestamp;
+  rxCompletion.operationBeginSimulationTimestamp = reception.beginSimulationTimestamp;
+  rxCompletion.operationBeginTruePosition = reception.beginTruePosition;
+  rxCompletion.operationEndClockTimestamp = reception.endClockTimestamp;
+  rxCompletion.operationEndSimulationTimestamp = reception.endSimulationTimestamp;
+  rxCompletion.operationEndTruePosition = reception.endTruePosition;
+  reception.transmissionId = -1;
 
-  EV_DETAIL_C("IdealRangingNicDriver") << "Frame " << rxCompletion.getFrame()->getClassName()
-                                       << " (ID: " << rxCompletion.getFrame()->getId() << ") reception completed at "
-                                       << clockTime() << " (local clock)" << endl;
+  // Frame is handed over to the application after the signal, so RX completion refers to it only during the signal
+  rxCompletion.frame = frame.get();
 
-  ClockDecorator<cSimpleModule>::emit(IRangingNicDriver::rxCompletedSignalId, &rxCompletion);
+  EV_DETAIL_C("IdealRangingNicDriver") << "Frame " << frame->getClassName() << " (ID: " << frame->getId()
+                                       << ") reception completed at " << clockTime() << " (local clock)" << endl;
+
+  notifyRxCompletion();
+  rxCompletion.frame = nullptr;
+  rxCompletionObject.setFrame(nullptr);
   send(frame.release(), "applicationOut");
 }
 
+void IdealRangingNicDriver::snapshotTxFrame(const inet::IdealMacFrame& frame)
+{
+  // Sent frame is owned by the NIC, so TX completion refers to a snapshot. Encapsulated packets are reference counted
+  // and shared with the sent frame, plain IdealMacFrame headers are assigned to the snapshot of the previous frame.
+  if (txFrame && typeid(*txFrame) == typeid(inet::IdealMacFrame) && typeid(frame) == typeid(inet::IdealMacFrame)) {
+    *txFrame = frame;
+  }
+  else {
+    txFrame.reset(frame.dup());
+  }
+}
+
 void IdealRangingNicDriver::handleRadioStateChanged(inet::physicallayer::IRadio::TransmissionState newState)
 {
   using inet::physicallayer::IRadio;
@@ -115,23 +173,23 @@ void IdealRangingNicDriver::handleRadioStateChanged(inet::physicallayer::IRadio:
     case IRadio::TRANSMISSION_STATE_IDLE:
       if (previousTxState == IRadio::TRANSMISSION_STATE_TRANSMITTING) {
         EV_DETAIL_C("IdealRangingNicDriver")
-            << "Frame " << txCompletion.getFrame()->getClassName() << " (ID: " << txCompletion.getFrame()->getId()
+            << "Frame " << txCompletion.frame->getClassName() << " (ID: " << txCompletion.frame->getId()
             << ") transmission completed at " << clockTime() << " (local clock)" << endl;
 
-        txCompletion.setOperationEndClockTimestamp(clockTime());
-        txCompletion.setOperationEndSimulationTimestamp(simTime());
-        txCompletion.setOperationEndTruePosition(mobility->getCurrentPosition());
+        txCompletion.operationEndClockTimestamp = clockTime();
+        txCompletion.operationEndSimulationTimestamp = simTime();
+        txCompletion.operationEndTruePosition = mobility->getCurrentPosition();
 
-        ClockDecorator<cSimpleModule>::emit(IRangingNicDriver::txCompletedSignalId, &txCompletion);
+        notifyTxCompletion();
       }
       break;
     case IRadio::TRANSMISSION_STATE_TRANSMITTING:
       EV_DETAIL_C("IdealRangingNicDriver")
-          << "Frame " << txCompletion.getFrame()->getClassName() << " (ID: " << txCompletion.getFrame()->getId()
+          << "Frame " << txCompletion.frame->getClassName() << " (ID: " << txCompletion.frame->getId()
           << ") transmission started at " << clockTime() << "(local clock)" << endl;
-      txCompletion.setOperationBeginClockTimestamp(clockTime());
-      txCompletion.setOperationBeginSimulationTimestamp(simTime());
-      txCompletion.setOperationBeginTruePosition(mobility->getCurrentPosition());
+      txCompletion.operationBeginClockTimestamp = clockTime();
+      txCompletion.operationBeginSimulationTimestamp = simTime();
+      txCompletion.operationBeginTruePosition = mobility->getCurrentPosition();
       break;
     case IRadio::TRANSMISSION_STATE_UNDEFINED:
       clearTxCompletion();
@@ -144,23 +202,19 @@ void IdealRangingNicDriver::handleRadioStateChanged(inet::physicallayer::IRadio:
 void IdealRangingNicDriver::handleRadioStateChanged(inet::physicallayer::IRadio::ReceptionState newState)
 {
   using inet::physicallayer::IRadio;
+  if (previousRxState == IRadio::RECEPTION_STATE_RECEIVING && newState != IRadio::RECEPTION_STATE_RECEIVING) {
+    endReception(currentReceptionId);
+  }
+
   switch (newState) {
     case IRadio::RECEPTION_STATE_BUSY:
       // TODO
       break;
     case IRadio::RECEPTION_STATE_IDLE:
-      if (previousRxState == IRadio::RECEPTION_STATE_RECEIVING) {
-        rxCompletion.setOperationEndClockTimestamp(clockTime());
-        rxCompletion.setOperationEndSimulationTimestamp(simTime());
-        rxCompletion.setOperationEndTruePosition(mobility->getCurrentPosition());
-      }
       break;
     case IRadio::RECEPTION_STATE_RECEIVING:
-      EV_DETAIL_C("IdealRangingNicDriver") << "Frame (Transmission ID: " << radio->getReceptionInProgress()->getId()
-                                           << ") reception started at " << clockTime() << "(local clock)" << endl;
-      rxCompletion.setOperationBeginClockTimestamp(clockTime());
-      rxCompletion.setOperationBeginSimulationTimestamp(simTime());
-      rxCompletion.setOperationBeginTruePosition(mobility->getCurrentPosition());
+      currentReceptionId = radio->getReceptionInProgress()->getId();
+      beginReception(currentReceptionId);
       break;
     case IRadio::RECEPTION_STATE_UNDEFINED:
       clearRxCompletion();
@@ -170,36 +224,156 @@ void IdealRangingNicDriver::handleRadioStateChanged(inet::physicallayer::IRadio:
   previousRxState = newState;
 }
 
-void IdealRangingNicDriver::clearRxCompletion()
+void IdealRangingNicDriver::handleTransmissionStarted()
 {
-  txCompletion.setStatus(IdealTxCompletionStatus::SUCCESS);
-  txCompletion.setFrame(nullptr);
-  txFrame.reset();
+  Enter_Method_Silent();
+  handleRadioStateChanged(inet::physicallayer::IRadio::TRANSMISSION_STATE_TRANSMITTING);
+}
+
+void IdealRangingNicDriver::handleTransmissionEnded()
+{
+  Enter_Method_Silent();
+  handleRadioStateChanged(inet::physicallayer::IRadio::TRANSMISSION_STATE_IDLE);
+}
+
+void IdealRangingNicDriver::handleReceptionStarted(int transmissionId)
+{
+  Enter_Method_Silent();
+  currentReceptionId = transmissionId;
+  beginReception(currentReceptionId);
+}
+
+void IdealRangingNicDriver::handleReceptionEnded(int transmissionId)
+{
+  Enter_Method_Silent();
+  endReception(transmissionId);
+  currentReceptionId = -1;
+}
+
+void IdealRangingNicDriver::handleFrameReceived(std::unique_ptr<inet::IdealMacFrame> frame)
+{
+  Enter_Method_Silent();
+  take(frame.get());
+  handleNicIn(std::move(frame));
+}
 
-  txCompletion.setOperationBeginClockTimestamp(0);
-  txCompletion.setOperationBeginSimulationTimestamp(simTime());
+void IdealRangingNicDriver::beginReception(int transmissionId)
+{
+  EV_DETAIL_C("IdealRangingNicDriver") << "Frame (Transmission ID: " << transmissionId << ") reception started at "
+                                       << clockTime() << "(local clock)" << endl;
+
+  auto slot = findReception(-1);
+  if (!slot) {
+    // Ended receptions whose frames weren't passed until now were dropped by the NIC
+    for (auto& reception : receptions) {
+      if (reception.ended && reception.endSimulationTimestamp < simTime()) {
+        reception.transmissionId = -1;
+      }
+    }
 
-  txCompletion.setOperationEndClockTimestamp(0);
-  txCompletion.setOperationEndSimulationTimestamp(simTime());
+    slot = findReception(-1);
+    if (!slot) {
+      throw cRuntimeError{"Too many concurrent receptions, increase \"maxConcurrentReceptions\" parameter"};
+    }
+  }
+
+  slot->transmissionId = transmissionId;
+  slot->ended = false;
+  slot->beginClockTimestamp = clockTime();
+  slot->beginSimulationTimestamp = simTime();
+  slot->beginTruePosition = mobility->getCurrentPosition();
+}
+
+void IdealRangingNicDriver::endReception(int transmissionId)
+{
+  auto reception = transmissionId != -1 ? findReception(transmissionId) : nullptr;
+  if (!reception) {
+    return;
+  }
+
+  reception->ended = true;
+  reception->endSequenceNumber = endedReceptionsCounter++;
+  reception->endClockTimestamp = clockTime();
+  reception->endSimulationTimestamp = simTime();
+  reception->endTruePosition = mobility->getCurrentPosition();
+}
+
+IdealRangingNicDriver::Reception& IdealRangingNicDriver::findCompletedReception()
+{
+  // NIC passes frames up at the time their receptions end and in the same order
+  Reception* completed{nullptr};
+  for (auto& reception : receptions) {
+    if (reception.transmissionId == -1 || !reception.ended || reception.endSimulationTimestamp != simTime()) {
+      continue;
+    }
+
+    if (!completed || reception.endSequenceNumber < completed->endSequenceNumber) {
+      completed = &reception;
+    }
+  }
+
+  if (!completed) {
+    throw cRuntimeError{"Received frame from NIC without completed reception"};
+  }
 
-  txCompletion.setOperationBeginTruePosition(inet::Coord{});
-  txCompletion.setOperationEndTruePosition(inet::Coord{});
+  return *completed;
+}
+
+IdealRangingNicDriver::Reception* IdealRangingNicDriver::findReception(int transmissionId)
+{
+  const auto reception = std::find_if(receptions.begin(), receptions.end(), [transmissionId](const Reception& entry) {
+    return entry.transmissionId == transmissionId;
+  });
+
+  return reception != receptions.end() ? &*reception : nullptr;
+}
+
+void IdealRangingNicDriver::clearRxCompletion()
+{
+  rxCompletion = IdealRxCompletionRecord{};
+  rxCompletion.operationBeginSimulationTimestamp = simTime();
+  rxCompletion.operationEndSimulationTimestamp = simTime();
+  rxCompletionObject.setFrame(nullptr);
+
+  for (auto& reception : receptions) {
+    reception.transmissionId = -1;
+  }
+  currentReceptionId = -1;
 }
 
 void IdealRangingNicDriver::clearTxCompletion()
 {
-  rxCompletion.setStatus(IdealRxCompletionStatus::SUCCESS);
-  rxCompletion.setFrame(nullptr);
-  rxFrame.reset();
+  txCompletion = IdealTxCompletionRecord{};
+  txCompletion.operationBeginSimulationTimestamp = simTime();
+  txCompletion.operationEndSimulationTimestamp = simTime();
+  txCompletionObject.setFrame(nullptr);
+  txFrame.reset();
+}
+
+void IdealRangingNicDriver::notifyTxCompletion()
+{
+  for (auto listener : completionListeners) {
+    listener->handleTxCompletion(txCompletion);
+  }
 
-  rxCompletion.setOperationBeginClockTimestamp(0);
-  rxCompletion.setOperationBeginSimulationTimestamp(simTime());
+  // Completion object is filled only for compatibility with signal listeners
+  if (mayHaveListeners(IRangingNicDriver::txCompletedSignalId)) {
+    copyCompletion(txCompletion, txCompletionObject);
+    ClockDecorator<cSimpleModule>::emit(IRangingNicDriver::txCompletedSignalId, &txCompletionObject);
+  }
+}
 
-  rxCompletion.setOperationEndClockTimestamp(0);
-  rxCompletion.setOperationEndSimulationTimestamp(simTime());
+void IdealRangingNicDriver::notifyRxCompletion()
+{
+  for (auto listener : completionListeners) {
+    listener->handleRxCompletion(rxCompletion);
+  }
 
-  rxCompletion.setOperationBeginTruePosition(inet::Coord{});
-  rxCompletion.setOperationEndTruePosition(inet::Coord{});
+  // Completion object is filled only for compatibility with signal listeners
+  if (mayHaveListeners(IRangingNicDriver::rxCompletedSignalId)) {
+    copyCompletion(rxCompletion, rxCompletionObject);
+    ClockDecorator<cSimpleModule>::emit(IRangingNicDriver::rxCompletedSignalId, &rxCompletionObject);
+  }
 }
 
 }  // namespace smile
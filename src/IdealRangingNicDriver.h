@@ -21,14 +21,19 @@
 #include <inet/mobility/contract/IMobility.h>
 #include <inet/physicallayer/contract/packetlevel/IRadio.h>
 #include <omnetpp.h>
+#include <cstdint>
+#include <vector>
 #include "ClockDecorator.h"
+#include "FastRangingNic.h"
 #include "IRangingNicDriver.h"
 #include "IdealRxCompletion_m.h"
 #include "IdealTxCompletion_m.h"
 
 namespace smile {
 
-class IdealRangingNicDriver : public ClockDecorator<omnetpp::cSimpleModule>, public IRangingNicDriver
+class IdealRangingNicDriver : public ClockDecorator<omnetpp::cSimpleModule>,
+                              public IRangingNicDriver,
+                              private FastRangingNic::IListener
 {
  public:
   IdealRangingNicDriver() = default;
@@ -41,6 +46,10 @@ class IdealRangingNicDriver : public ClockDecorator<omnetpp::cSimpleModule>, pub
 
   inet::MACAddress getMacAddress() const override;
 
+  void addCompletionListener(ICompletionListener* listener) override;
+
+  void removeCompletionListener(ICompletionListener* listener) override;
+
  protected:
   using ClockDecorator<omnetpp::cSimpleModule>::receiveSignal;
 
@@ -56,19 +65,71 @@ class IdealRangingNicDriver : public ClockDecorator<omnetpp::cSimpleModule>, pub
 
   void handleNicIn(std::unique_ptr<inet::IdealMacFrame> frame);
 
+  // Copies the frame to txFrame without deep copy of its encapsulated packets
+  void snapshotTxFrame(const inet::IdealMacFrame& frame);
+
   void handleRadioStateChanged(inet::physicallayer::IRadio::TransmissionState newState);
 
   void handleRadioStateChanged(inet::physicallayer::IRadio::ReceptionState newState);
 
+  // FastRangingNic events are mapped to the same operations as radio state changes
+  void handleTransmissionStarted() override;
+
+  void handleTransmissionEnded() override;
+
+  void handleReceptionStarted(int transmissionId) override;
+
+  void handleReceptionEnded(int transmissionId) override;
+
+  void handleFrameReceived(std::unique_ptr<inet::IdealMacFrame> frame) override;
+
   void clearRxCompletion();
 
   void clearTxCompletion();
 
-  IdealTxCompletion txCompletion;
-  IdealRxCompletion rxCompletion;
+  void notifyTxCompletion();
+
+  void notifyRxCompletion();
+
+  struct Reception
+  {
+    // Transmission ID, -1 marks a free slot
+    int transmissionId{-1};
+    bool ended{false};
+    uint64_t endSequenceNumber{0};
+    omnetpp::SimTime beginClockTimestamp;
+    omnetpp::SimTime beginSimulationTimestamp;
+    omnetpp::SimTime endClockTimestamp;
+    omnetpp::SimTime endSimulationTimestamp;
+    inet::Coord beginTruePosition;
+    inet::Coord endTruePosition;
+  };
+
+  void beginReception(int transmissionId);
+
+  void endReception(int transmissionId);
+
+  // Returns reception of the frame passed by the NIC, slot is freed when the RX completion is filled
+  Reception& findCompletedReception();
+
+  Reception* findReception(int transmissionId);
+
+  IdealTxCompletionRecord txCompletion;
+  IdealRxCompletionRecord rxCompletion;
+
+  // Passed to txCompleted and rxCompleted signals
+  IdealTxCompletion txCompletionObject;
+  IdealRxCompletion rxCompletionObject;
+
+  std::vector<ICompletionListener*> completionListeners;
   std::unique_ptr<inet::IdealMacFrame> txFrame;
-  std::unique_ptr<inet::IdealMacFrame> rxFrame;
+
+  // Receptions in progress and ended ones whose frames weren't passed from the NIC yet, slots are preallocated
+  std::vector<Reception> receptions;
+  uint64_t endedReceptionsCounter{0};
+  int currentReceptionId{-1};
   inet::physicallayer::IRadio* radio{nullptr};
+  FastRangingNic* fastNic{nullptr};
   cModule* nic{nullptr};
   cModule* mac{nullptr};
   inet::IMobility* mobility{nullptr};
@@ -0,0 +1,86 @@
+//
+// Copyright (C) 2018 Tomasz Jankowski <t.jankowski AT pwr.edu.pl>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "LiuYangClock.h"
+#include <inet/common/INETDefs.h>
+#include <cmath>
+
+namespace smile {
+
+Define_Module(LiuYangClock);
+
+void LiuYangClock::initialize(int stage)
+{
+  Clock::initialize(stage);
+
+  if (stage == inet::INITSTAGE_LOCAL) {
+    drift = par("__constant_drift");
+    if (drift <= -1) {
+      throw cRuntimeError{"Clock drift has to be greater than -1, got %g", drift};
+    }
+
+    // Hardware time starts in sync with simulation time
+    startTimestamp = simTime();
+  }
+}
+
+int64_t LiuYangClock::hardwareTicks(int64_t simulationTicks) const
+{
+  // Only the small drift term is computed in floating point, so whole ticks are never lost
+  return simulationTicks + static_cast<int64_t>(std::floor(simulationTicks * drift));
+}
+
+omnetpp::SimTime LiuYangClock::hardwareTimestampAt(const SimTime& simulationTimestamp) const
+{
+  const auto ticks = hardwareTicks((simulationTimestamp - startTimestamp).raw());
+  return startTimestamp + SimTime::fromRaw(ticks);
+}
+
+size_t LiuYangClock::convertToSimulationTimestamps(const std::vector<SimTime>& timestamps,
+                                                   std::vector<SimTime>& simulationTimestamps)
+{
+  // Every conversion is O(1) and always succeeds
+  simulationTimestamps.clear();
+  for (const auto& timestamp : timestamps) {
+    simulationTimestamps.push_back(*convertToSimulationTimestamp(timestamp));
+  }
+
+  return simulationTimestamps.size();
+}
+
+omnetpp::SimTime LiuYangClock::getClockTimestamp()
+{
+  return hardwareTimestampAt(simTime());
+}
+
+LiuYangClock::OptionalSimTime LiuYangClock::convertToSimulationTimestamp(const SimTime& timestamp)
+{
+  // Returns the earliest simulation time at which the clock shows at least timestamp. Hardware time is
+  // a non-decreasing function of simulation time, so the inverted estimate is corrected by few ticks at most.
+  const auto target = (timestamp - startTimestamp).raw();
+  auto ticks = target - static_cast<int64_t>(std::floor(target * drift / (1 + drift)));
+  while (hardwareTicks(ticks) < target) {
+    ticks++;
+  }
+  while (hardwareTicks(ticks - 1) >= target) {
+    ticks--;
+  }
+
+  return startTimestamp + SimTime::fromRaw(ticks);
+}
+
+}  // namespace smile
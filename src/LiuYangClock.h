@@ -0,0 +1,55 @@
+//
+// Copyright (C) 2018 Tomasz Jankowski <t.jankowski AT pwr.edu.pl>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#pragma once
+
+#include <omnetpp.h>
+#include <cstdint>
+#include "Clock.h"
+
+namespace smile {
+
+class LiuYangClock : public Clock
+{
+ public:
+  LiuYangClock() = default;
+  LiuYangClock(const LiuYangClock& source) = delete;
+  LiuYangClock(LiuYangClock&& source) = delete;
+  ~LiuYangClock() override = default;
+
+  LiuYangClock& operator=(const LiuYangClock& source) = delete;
+  LiuYangClock& operator=(LiuYangClock&& source) = delete;
+
+  omnetpp::SimTime getClockTimestamp() override;
+  OptionalSimTime convertToSimulationTimestamp(const omnetpp::SimTime& timestamp) override;
+  size_t convertToSimulationTimestamps(const std::vector<omnetpp::SimTime>& timestamps,
+                                       std::vector<omnetpp::SimTime>& simulationTimestamps) override;
+
+  // Returns hardware time t0 + (t - t0) * (1 + drift), rounded down to the timestamp resolution
+  omnetpp::SimTime hardwareTimestampAt(const omnetpp::SimTime& simulationTimestamp) const;
+
+ protected:
+  void initialize(int stage) override;
+
+ private:
+  int64_t hardwareTicks(int64_t simulationTicks) const;
+
+  omnetpp::SimTime startTimestamp;
+  double drift{0};
+};
+
+}  // namespace smile
@@ -35,15 +35,54 @@
 */
 
 #include "DriftSource.h"
+#include <algorithm>
 
 using namespace omnetpp;
 
 namespace smile {
 namespace steinhauser_clock {
 
+namespace {
+
+const double driftLimit = -0.999999;
+
+/// Philox4x32-10 block function (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3").
+uint32_t philox4x32(uint64_t index, const uint32_t (&key)[2])
+{
+  const uint32_t multiplier0 = 0xD2511F53;
+  const uint32_t multiplier1 = 0xCD9E8D57;
+  const uint32_t weyl0 = 0x9E3779B9;
+  const uint32_t weyl1 = 0xBB67AE85;
+
+  uint32_t counter[4] = {static_cast<uint32_t>(index), static_cast<uint32_t>(index >> 32), 0, 0};
+  uint32_t k0 = key[0];
+  uint32_t k1 = key[1];
+
+  for (int round = 0; round < 10; round++) {
+    const uint64_t product0 = static_cast<uint64_t>(multiplier0) * counter[0];
+    const uint64_t product1 = static_cast<uint64_t>(multiplier1) * counter[2];
+
+    const uint32_t c0 = static_cast<uint32_t>(product1 >> 32) ^ counter[1] ^ k0;
+    const uint32_t c1 = static_cast<uint32_t>(product1);
+    const uint32_t c2 = static_cast<uint32_t>(product0 >> 32) ^ counter[3] ^ k1;
+    const uint32_t c3 = static_cast<uint32_t>(product0);
+
+    counter[0] = c0;
+    counter[1] = c1;
+    counter[2] = c2;
+    counter[3] = c3;
+
+    k0 += weyl0;
+    k1 += weyl1;
+  }
+
+  return counter[0];
+}
+
+}  // namespace
+
 double DriftSource::nextValue()
 {
-  const double driftLimit = -0.999999;
   const double n = next();
 
   // limit drift to values > -1, so the time can't go back
@@ -54,6 +93,23 @@ double DriftSource::nextValue()
   return n;
 }
 
+void DriftSource::fillValues(double* out, size_t n)
+{
+  generate(out, n);
+
+  // limit drift to values > -1, so the time can't go back (branch-free, so the loop can be vectorized)
+  for (size_t i = 0; i < n; i++) {
+    out[i] = std::max(out[i], driftLimit);
+  }
+}
+
+void DriftSource::generate(double* out, size_t n)
+{
+  for (size_t i = 0; i < n; i++) {
+    out[i] = next();
+  }
+}
+
 ConstantDrift::ConstantDrift(double drift) : drift(drift) {}
 
 double ConstantDrift::next()
@@ -61,6 +117,11 @@ double ConstantDrift::next()
   return drift;
 }
 
+void ConstantDrift::generate(double* out, size_t n)
+{
+  std::fill(out, out + n, drift);
+}
+
 BoundedDrift::BoundedDrift(const cPar& distribution) : distribution(distribution) {}
 
 double BoundedDrift::next()
@@ -68,6 +129,14 @@ double BoundedDrift::next()
   return distribution.doubleValue();
 }
 
+void BoundedDrift::generate(double* out, size_t n)
+{
+  // values have to be drawn one by one to keep the order of the RNG stream
+  for (size_t i = 0; i < n; i++) {
+    out[i] = distribution.doubleValue();
+  }
+}
+
 BoundedDriftVariation::BoundedDriftVariation(const cPar& distribution, double max_drift_variation, double start_value,
                                              const simtime_t& tint) :
     BoundedDrift(distribution),
@@ -75,22 +144,48 @@ BoundedDriftVariation::BoundedDriftVariation(const cPar& distribution, double ma
     last_drift(start_value)
 {}
 
+double BoundedDriftVariation::limit(double drift) const
+{
+  const double diff = drift - last_drift;
+
+  // limit the drift, selects instead of branches so the compiler can emit conditional moves
+  const double lower = diff < -max_drift_change ? last_drift - max_drift_change : drift;
+  return diff > max_drift_change ? last_drift + max_drift_change : lower;
+}
+
 double BoundedDriftVariation::next()
 {
-  double drift = BoundedDrift::next();
+  last_drift = limit(BoundedDrift::next());
+  return last_drift;
+}
 
-  double diff = drift - last_drift;
+void BoundedDriftVariation::generate(double* out, size_t n)
+{
+  BoundedDrift::generate(out, n);
 
-  // limit the drift
-  if (diff > max_drift_change) {
-    drift = last_drift + max_drift_change;
-  }
-  else if (diff < -max_drift_change) {
-    drift = last_drift - max_drift_change;
+  // every value is limited with respect to the previous one, hence the sequential pass
+  for (size_t i = 0; i < n; i++) {
+    last_drift = limit(out[i]);
+    out[i] = last_drift;
   }
+}
 
-  last_drift = drift;
-  return drift;
+CounterDrift::CounterDrift(double range, uint32_t seedKey, uint32_t clockKey) :
+    range(range),
+    key{seedKey, clockKey}
+{}
+
+double CounterDrift::next()
+{
+  return valueAt(counter++);
+}
+
+double CounterDrift::valueAt(uint64_t k) const
+{
+  const double drift = (philox4x32(k, key) >> 31) ? -range : range;
+
+  // nextValue() limits values the same way
+  return std::max(drift, driftLimit);
 }
 
 }  // namespace steinhauser_clock
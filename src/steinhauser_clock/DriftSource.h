@@ -37,6 +37,8 @@
 #pragma once
 
 #include <omnetpp.h>
+#include <cstddef>
+#include <cstdint>
 
 namespace smile {
 namespace steinhauser_clock {
@@ -47,11 +49,24 @@ class DriftSource
  protected:
   virtual double next() = 0;
 
+  /// Writes the next n raw drift values to out.
+  ///
+  /// The default implementation calls next() n times, sources override
+  /// it to produce the whole block at once.
+  virtual void generate(double* out, size_t n);
+
  public:
   virtual ~DriftSource() = default;
 
   /// \returns	The next drift value.
   double nextValue();
+
+  /// Writes the next n drift values to out.
+  ///
+  /// The values are the same as n consecutive calls to nextValue() would return.
+  /// \param out	Buffer for at least n drift values.
+  /// \param n	The number of values to generate.
+  void fillValues(double* out, size_t n);
 };
 
 /// \brief A constant drift source.
@@ -65,6 +80,8 @@ class ConstantDrift : public DriftSource
  protected:
   double next();
 
+  void generate(double* out, size_t n) override;
+
  public:
   /// Initalizes the object.
   ///
@@ -81,6 +98,8 @@ class BoundedDrift : public DriftSource
  protected:
   double next();
 
+  void generate(double* out, size_t n) override;
+
  public:
   /// Initalizes the object.
   ///
@@ -98,9 +117,14 @@ class BoundedDriftVariation : public BoundedDrift
 
   double last_drift;
 
+  /// Limits the variation of the given drift value with respect to last_drift.
+  double limit(double drift) const;
+
  protected:
   double next();
 
+  void generate(double* out, size_t n) override;
+
  public:
   /// Initalizes the object.
   ///
@@ -115,5 +139,38 @@ class BoundedDriftVariation : public BoundedDrift
   BoundedDriftVariation(const omnetpp::cPar& distribution, double max_drift_variation, double start_value,
                         const omnetpp::simtime_t& tint);
 };
+
+/// \brief Random-access source of drift values with random sign.
+///
+/// The drift of hold point k is +range or -range, with the sign taken from
+/// a Philox4x32-10 counter-based generator evaluated at counter k. Hence the drift
+/// of any hold point can be computed directly, without generating the preceding ones.
+class CounterDrift : public DriftSource
+{
+ private:
+  double range;
+
+  /// Key of the generator, the first word is derived from the run seed
+  /// and the second one identifies the clock.
+  uint32_t key[2];
+
+  /// Index of the value returned by next().
+  uint64_t counter{0};
+
+ protected:
+  double next();
+
+ public:
+  /// Initalizes the object.
+  ///
+  /// \param range	Absolute value of the drift.
+  /// \param seedKey	Key word derived from the run seed.
+  /// \param clockKey	Key word unique for the clock.
+  CounterDrift(double range, uint32_t seedKey, uint32_t clockKey);
+
+  /// \returns	The drift value of hold point k (the same one nextValue() returns
+  ///		for its k-th call).
+  double valueAt(uint64_t k) const;
+};
 }  // namespace steinhauser_clock
 }  // namespace smile
@@ -0,0 +1,112 @@
+//
+// Copyright (C) 2018 Tomasz Jankowski <t.jankowski AT pwr.edu.pl>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "LinearTrajectory.h"
+#include "VectorSummary.h"
+
+using namespace omnetpp;
+
+namespace smile {
+namespace steinhauser_clock {
+
+LinearTrajectory::LinearTrajectory(const SteinhauserClock::Properties& properties, double drift,
+                                   VectorSummary* summary) :
+    properties(properties),
+    drift(drift),
+    begin(simTime()),
+    hardwareInterval(properties.tint() * (1 + drift)),
+    summary(summary)
+{
+  if (hardwareInterval.raw() <= 0) {
+    throw cRuntimeError{"Drift %g makes hardware time stop", drift};
+  }
+
+  driftVector.setName("drift");
+  timeVector.setName("hardware_time");
+  deviationVector.setName("time_deviation");
+  driftHistogram.setName("drift_values");
+
+  timeVector.setUnit("s");
+  deviationVector.setUnit("s");
+
+  recordVectors(at(0));
+}
+
+LinearTrajectory::~LinearTrajectory()
+{
+  delete summary;
+}
+
+void LinearTrajectory::finish()
+{
+  const int64_t last = indexOf(simTime());
+  if (last > 0) {
+    recordVectors(at(last));
+  }
+
+  for (int64_t k = 0; k <= last; k++) {
+    driftHistogram.collect(drift);
+  }
+  driftHistogram.recordAs("drift_distribution");
+
+  if (summary) {
+    summary->finish();
+  }
+}
+
+void LinearTrajectory::recordVectors(const StorageWindow::HoldPoint& hp)
+{
+  if (summary) {
+    summary->collect(hp.realTime, hp.drift, (hp.hardwareTime - hp.realTime).dbl());
+    return;
+  }
+
+  driftVector.recordWithTimestamp(hp.realTime, hp.drift);
+  timeVector.recordWithTimestamp(hp.realTime, hp.hardwareTime);
+  deviationVector.recordWithTimestamp(hp.realTime, hp.hardwareTime - hp.realTime);
+}
+
+StorageWindow::HoldPoint LinearTrajectory::at(int64_t k) const
+{
+  StorageWindow::HoldPoint hp;
+  hp.realTime = begin + SimTime::fromRaw(properties.tint().raw() * k);
+  hp.hardwareTime = begin + SimTime::fromRaw(hardwareInterval.raw() * k);
+  hp.drift = drift;
+  return hp;
+}
+
+int64_t LinearTrajectory::indexOf(const simtime_t& t) const
+{
+  const int64_t ticks = (t - begin).raw();
+  const int64_t tint = properties.tint().raw();
+
+  // round towards negative infinity, timestamps before the first hold point use its line
+  return ticks >= 0 ? ticks / tint : -((-ticks + tint - 1) / tint);
+}
+
+int64_t LinearTrajectory::hardwareIndexOf(const simtime_t& t) const
+{
+  const int64_t ticks = (t - begin).raw();
+  if (ticks <= 0) {
+    return 0;
+  }
+
+  return (ticks - 1) / hardwareInterval.raw();
+}
+
+}  // namespace steinhauser_clock
+}  // namespace smile
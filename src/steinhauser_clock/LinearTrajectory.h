@@ -0,0 +1,106 @@
+//
+// Copyright (C) 2018 Tomasz Jankowski <t.jankowski AT pwr.edu.pl>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#pragma once
+
+#include <omnetpp.h>
+#include <cstdint>
+#include "SteinhauserClock.h"
+#include "StorageWindow.h"
+
+namespace smile {
+namespace steinhauser_clock {
+
+class VectorSummary;
+
+/// \brief Closed form trajectory of a clock with constant drift.
+///
+/// All hold points lie on a straight line: hold point k is at simulation
+/// time t0 + k * tint and hardware time t0 + k * (tint * (1 + drift)), which
+/// are exactly the values StorageWindow accumulates for a constant drift.
+/// Any hold point is computed in O(1), so no window has to be kept.
+class LinearTrajectory
+{
+ private:
+  /// The properties of the clock this object belongs to.
+  const SteinhauserClock::Properties& properties;
+
+  /// The constant drift value.
+  double drift;
+
+  /// Simulation (and hardware) time of the first hold point.
+  omnetpp::simtime_t begin;
+
+  /// Hardware time between two hold points.
+  omnetpp::simtime_t hardwareInterval;
+
+  /// Optional summary recorded instead of the vectors.
+  VectorSummary* summary{nullptr};
+
+  /// Vector to record the drift values.
+  omnetpp::cOutVector driftVector;
+
+  /// Vector to record the hardware timestamps.
+  omnetpp::cOutVector timeVector;
+
+  /// Vector to record the deviation between the hardware
+  /// and simulation time.
+  omnetpp::cOutVector deviationVector;
+
+  // Collects statistics about the drift values.
+  omnetpp::cDoubleHistogram driftHistogram;
+
+  /// Records the hold point to the vector files or to the summary, if set.
+  void recordVectors(const StorageWindow::HoldPoint& hp);
+
+ public:
+  /// Initializes the trajectory.
+  ///
+  /// \param properties	Properties object of the simulated hardware clock.
+  /// \param drift	The constant drift value.
+  /// \param summary	Optional summary replacing the vectors, the object takes
+  ///			ownership of the object being passed.
+  LinearTrajectory(const SteinhauserClock::Properties& properties, double drift, VectorSummary* summary = nullptr);
+
+  ~LinearTrajectory();
+
+  /// Writes out statistics.
+  ///
+  /// Vectors contain the first hold point and the one of the current simulation
+  /// time, the drift histogram gets a value for every hold point passed.
+  void finish();
+
+  /// Returns the hold point at index k.
+  StorageWindow::HoldPoint at(int64_t k) const;
+
+  /// Calculates the hold point index for a timestamp.
+  ///
+  /// \param t	A simulation timestamp.
+  /// \returns	The index of the hold point in what the simulation time lies,
+  ///		negative for timestamps before the first hold point.
+  int64_t indexOf(const omnetpp::simtime_t& t) const;
+
+  /// Calculates the hold point index for a hardware timestamp.
+  ///
+  /// \param t	A hardware timestamp.
+  /// \returns	The index of the last hold point whose hardware time is
+  ///		lower than t, or 0 if there is no such hold point.
+  int64_t hardwareIndexOf(const omnetpp::simtime_t& t) const;
+};
+
+}  // namespace steinhauser_clock
+}  // namespace smile
@@ -0,0 +1,125 @@
+//
+// Copyright (C) 2018 Tomasz Jankowski <t.jankowski AT pwr.edu.pl>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "SeekableTrajectory.h"
+#include <algorithm>
+#include <exception>
+#include "DriftSource.h"
+
+using namespace omnetpp;
+
+namespace smile {
+namespace steinhauser_clock {
+
+SeekableTrajectory::SeekableTrajectory(const SteinhauserClock::Properties& properties, CounterDrift* source) :
+    properties(properties),
+    source(source)
+{
+  const simtime_t now = simTime();
+  checkpoints.push_back(Checkpoint{now, now});
+}
+
+SeekableTrajectory::~SeekableTrajectory() = default;
+
+void SeekableTrajectory::appendCheckpoint()
+{
+  const size_t k = firstIndex + checkpoints.size() * properties.u();
+  const StorageWindow::HoldPoint last = fromCheckpoint(checkpoints.size() - 1, k - 1);
+
+  Checkpoint checkpoint;
+  checkpoint.realTime = last.realTime + properties.tint();
+  checkpoint.hardwareTime = last.hardwareTime + properties.tint() * (1 + last.drift);
+  checkpoints.push_back(checkpoint);
+}
+
+StorageWindow::HoldPoint SeekableTrajectory::fromCheckpoint(size_t checkpoint, size_t k) const
+{
+  // hardware time is accumulated the same way as StorageWindow does it
+  StorageWindow::HoldPoint hp;
+  hp.realTime = checkpoints[checkpoint].realTime;
+  hp.hardwareTime = checkpoints[checkpoint].hardwareTime;
+
+  for (size_t i = firstIndex + checkpoint * properties.u(); i < k; i++) {
+    hp.realTime += properties.tint();
+    hp.hardwareTime += properties.tint() * (1 + source->valueAt(i));
+  }
+
+  hp.drift = source->valueAt(k);
+  return hp;
+}
+
+void SeekableTrajectory::discardBefore(size_t k)
+{
+  while (checkpoints.size() > 1 && firstIndex + properties.u() <= k) {
+    checkpoints.pop_front();
+    firstIndex += properties.u();
+  }
+}
+
+StorageWindow::HoldPoint SeekableTrajectory::at(size_t k)
+{
+  if (k < firstIndex) {
+    throw std::logic_error("SeekableTrajectory::at: hold point was discarded");
+  }
+
+  const size_t checkpoint = (k - firstIndex) / properties.u();
+  while (checkpoint >= checkpoints.size()) {
+    appendCheckpoint();
+  }
+
+  return fromCheckpoint(checkpoint, k);
+}
+
+size_t SeekableTrajectory::indexOf(const simtime_t& t) const
+{
+  return firstIndex + static_cast<size_t>((t - checkpoints.front().realTime) / properties.tint());
+}
+
+size_t SeekableTrajectory::hardwareIndexOf(const simtime_t& t)
+{
+  while (checkpoints.back().hardwareTime < t) {
+    appendCheckpoint();
+  }
+
+  // the last checkpoint with hardware time lower than t
+  auto predicate = [](const simtime_t& value, const Checkpoint& checkpoint) {
+    return value <= checkpoint.hardwareTime;
+  };
+
+  const auto next = std::upper_bound(checkpoints.begin(), checkpoints.end(), t, predicate);
+  if (next == checkpoints.begin()) {
+    return firstIndex;
+  }
+
+  // walk the hold points of the checkpoint
+  const size_t checkpoint = (next - checkpoints.begin()) - 1;
+  size_t k = firstIndex + checkpoint * properties.u();
+  StorageWindow::HoldPoint hp = fromCheckpoint(checkpoint, k);
+  for (size_t i = 1; i < properties.u(); i++) {
+    hp.hardwareTime += properties.tint() * (1 + hp.drift);
+    if (!(hp.hardwareTime < t)) {
+      break;
+    }
+
+    hp.drift = source->valueAt(++k);
+  }
+
+  return k;
+}
+
+}  // namespace steinhauser_clock
+}  // namespace smile
@@ -0,0 +1,101 @@
+//
+// Copyright (C) 2018 Tomasz Jankowski <t.jankowski AT pwr.edu.pl>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#pragma once
+
+#include <omnetpp.h>
+#include <deque>
+#include <memory>
+#include "SteinhauserClock.h"
+#include "StorageWindow.h"
+
+namespace smile {
+namespace steinhauser_clock {
+
+class CounterDrift;
+
+/// \brief Clock trajectory with random-access hold points.
+///
+/// Drift values come from a CounterDrift source, so instead of a storage window
+/// only checkpoints (simulation and hardware time of every u-th hold point) are kept.
+/// Checkpoints are generated on demand, so hold points arbitrarily far ahead can be
+/// reached, and the ones behind the current hold point are discarded.
+class SeekableTrajectory
+{
+ private:
+  struct Checkpoint
+  {
+    omnetpp::simtime_t realTime;
+    omnetpp::simtime_t hardwareTime;
+  };
+
+  /// The properties of the clock this object belongs to.
+  const SteinhauserClock::Properties& properties;
+
+  std::unique_ptr<CounterDrift> source;
+
+  /// Checkpoints of hold points firstIndex, firstIndex + u, ...
+  std::deque<Checkpoint> checkpoints;
+
+  /// Index of the hold point of the first checkpoint.
+  size_t firstIndex{0};
+
+  /// Appends the checkpoint following the last one.
+  void appendCheckpoint();
+
+  /// Returns the hold point at index k, starting from its checkpoint.
+  StorageWindow::HoldPoint fromCheckpoint(size_t checkpoint, size_t k) const;
+
+ public:
+  /// Initializes the trajectory.
+  ///
+  /// \param properties	Properties object of the simulated hardware clock.
+  /// \param source	Source of drift values, the object takes ownership of it.
+  SeekableTrajectory(const SteinhauserClock::Properties& properties, CounterDrift* source);
+
+  ~SeekableTrajectory();
+
+  /// Discards checkpoints that are not needed to reach hold point k and later ones.
+  void discardBefore(size_t k);
+
+  /// Returns the time at the beginning of the trajectory (the first kept hold point).
+  const omnetpp::simtime_t& hardwareTimeBegin() const
+  {
+    return checkpoints.front().hardwareTime;
+  }
+
+  /// Returns the hold point at index k.
+  ///
+  /// If the hold point was discarded, an std::logic_error exception is thrown.
+  StorageWindow::HoldPoint at(size_t k);
+
+  /// Calculates the hold point index for a timestamp.
+  ///
+  /// \param t	A simulation timestamp.
+  /// \returns	The index of the hold point in what the simulation time lies.
+  size_t indexOf(const omnetpp::simtime_t& t) const;
+
+  /// Calculates the hold point index for a hardware timestamp.
+  ///
+  /// \param t	A hardware timestamp.
+  /// \returns	The index of the last hold point whose hardware time is
+  ///		lower than t, or the first kept one if there is no such hold point.
+  size_t hardwareIndexOf(const omnetpp::simtime_t& t);
+};
+
+}  // namespace steinhauser_clock
+}  // namespace smile
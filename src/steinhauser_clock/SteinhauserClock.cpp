@@ -36,18 +36,44 @@
 
 #include "SteinhauserClock.h"
 #include <inet/common/INETDefs.h>
+#include <inet/common/ModuleAccess.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <exception>
+#include <experimental/filesystem>
 #include "DriftSource.h"
+#include "LinearTrajectory.h"
+#include "SeekableTrajectory.h"
+#include "SteinhauserClockEngine.h"
 #include "StorageWindow.h"
+#include "TrajectoryCache.h"
+#include "VectorSummary.h"
 
 using namespace omnetpp;
 
 namespace smile {
 namespace steinhauser_clock {
 
+namespace {
+
+/// 64-bit FNV-1a hash of the text.
+uint64_t fnv1a(const std::string& text)
+{
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (const char c : text) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 0x100000001b3ULL;
+  }
+
+  return hash;
+}
+
+}  // namespace
+
 Define_Module(SteinhauserClock);
 
-void SteinhauserClock::Properties::set(const simtime_t& tint, size_t u)
+void SteinhauserClock::Properties::set(const simtime_t& tint, size_t u, size_t sMax)
 {
   // minimum values
   simtime_t tint_min = SimTime::parse("1ms");
@@ -69,6 +95,9 @@ void SteinhauserClock::Properties::set(const simtime_t& tint, size_t u)
     _u = u;
   }
   _s = 2 * _u;
+
+  // the window grows and shrinks by u hold points
+  _sMax = std::max(_s, (sMax + _u - 1) / _u * _u);
 }
 
 SteinhauserClock::~SteinhauserClock()
@@ -90,6 +119,26 @@ void SteinhauserClock::cleanup()
     storageWindow = NULL;
   }
 
+  if (trajectory) {
+    delete trajectory;
+    trajectory = NULL;
+  }
+
+  if (linearTrajectory) {
+    delete linearTrajectory;
+    linearTrajectory = NULL;
+  }
+
+  if (trajectoryCache) {
+    delete trajectoryCache;
+    trajectoryCache = NULL;
+  }
+
+  if (trajectoryRecorder) {
+    delete trajectoryRecorder;
+    trajectoryRecorder = NULL;
+  }
+
   // NOTE: selfMsg isn't deleted
 }
 
@@ -101,12 +150,40 @@ void SteinhauserClock::initialize(int stage)
     // if needed, clean up stuff from the last run
     cleanup();
 
-    properties.set(par("interval"), par("update"));
+    adaptiveWindow = par("adaptiveWindow");
+    const int maxWindowSize = par("maxWindowSize");
+    if (adaptiveWindow && maxWindowSize < 1) {
+      throw cRuntimeError{"Parameter \"maxWindowSize\" has to be positive"};
+    }
+
+    properties.set(par("interval"), par("update"), adaptiveWindow ? maxWindowSize : 0);
 
     EV << "update interval: " << properties.updateInterval() << "s\n";
 
     DriftSource* d = NULL;
 
+    const std::string cacheDirectory = par("trajectoryCacheDirectory").stdstringValue();
+    if (!cacheDirectory.empty() && (hasPar("__counter_drift_range") || !par("engineModule").stdstringValue().empty())) {
+      throw cRuntimeError{"Trajectory cache can be used only by clocks with own storage window"};
+    }
+
+    if (hasPar("__counter_drift_range")) {
+      if (!par("engineModule").stdstringValue().empty()) {
+        throw cRuntimeError{"Counter-based clock can't be used with \"engineModule\""};
+      }
+
+      // drift of any hold point can be computed directly, no storage window is needed. The key is
+      // derived from the seed set and the node, so neither other RNG consumers nor module IDs
+      // affect the trajectory.
+      const uint32_t seedKey = std::stoul(getEnvir()->getConfigEx()->getVariable(CFGVAR_SEEDSET));
+      const int counterKey = par("counterKey");
+      const uint32_t clockKey = counterKey >= 0 ? counterKey : fnv1a(getFullPath());
+      auto source = new CounterDrift(par("__counter_drift_range"), seedKey, clockKey);
+      trajectory = new SeekableTrajectory(properties, source);
+      updateDisplay();
+      return;
+    }
+
     if (hasPar("__drift_distribution")) {
       if (hasPar("max_drift_variation")) {
         d = new BoundedDriftVariation(par("__drift_distribution"), par("max_drift_variation"), par("start_value"),
@@ -117,14 +194,53 @@ void SteinhauserClock::initialize(int stage)
       }
     }
     else {
-      d = new ConstantDrift(par("__constant_drift"));
+      // all hold points of a constant drift lie on a straight line and are calculated directly,
+      // no storage window, updates or cache are needed
+      ConstantDrift source{par("__constant_drift")};
+      linearTrajectory = new LinearTrajectory(properties, source.nextValue(), createVectorSummary());
+      updateDisplay();
+      return;
     }
 
-    storageWindow = new StorageWindow(properties, d);
-    updateDisplay();
+    lazy = par("lazy");
 
-    cMessage* msg = new cMessage("storage window update");
-    nextUpdate(msg);
+    if (adaptiveWindow && (lazy || !par("engineModule").stdstringValue().empty())) {
+      delete d;
+      throw cRuntimeError{"Parameter \"adaptiveWindow\" can't be used with \"lazy\" or \"engineModule\""};
+    }
+
+    if (par("engineModule").stdstringValue().empty()) {
+      if (!cacheDirectory.empty() && openTrajectoryCache(cacheDirectory)) {
+        // trajectory was generated by a previous run
+        delete d;
+        updateDisplay();
+        return;
+      }
+
+      storageWindow = new StorageWindow(properties, d, trajectoryRecorder, createVectorSummary());
+      updateDisplay();
+
+      if (adaptiveWindow) {
+        windowSizeVector.setName("storage_window_size");
+        timersBeyondWindowVector.setName("timers_beyond_window");
+        peakWindowSize = storageWindow->size();
+        windowSizeVector.record(storageWindow->size());
+      }
+
+      if (!lazy) {
+        cMessage* msg = new cMessage("storage window update");
+        nextUpdate(msg);
+      }
+    }
+    else if (lazy) {
+      delete d;
+      throw cRuntimeError{"Parameters \"lazy\" and \"engineModule\" can't be used together"};
+    }
+    else {
+      // hold points are kept and updated by the shared engine
+      engine = inet::getModuleFromPar<SteinhauserClockEngine>(par("engineModule"), this, true);
+      engineIndex = engine->registerClock(this, properties, d);
+    }
   }
 }
 
@@ -133,22 +249,173 @@ void SteinhauserClock::handleMessage(cMessage* msg)
   if (msg->isSelfMessage()) {
     // the only self message is to update the storage window
 
-    storageWindow->update();
+    updateStorageWindow();
     updateDisplay();
 
+    releaseTimers();
+    if (adaptiveWindow) {
+      // timers that still wait for conversion measure the latency caused by the window size
+      timersBeyondWindowVector.record(getTimerService()->size());
+    }
     emit(windowUpdateSignal, getClockTimestamp());
 
     nextUpdate(msg);
   }
 }
 
+void SteinhauserClock::updateStorageWindow()
+{
+  if (!adaptiveWindow) {
+    storageWindow->update();
+    return;
+  }
+
+  const size_t previousSize = storageWindow->size();
+  const auto horizon = getTimerService()->furthestClockTimestamp();
+
+  if (!horizon || *horizon <= storageWindow->hardwareTimeEnd()) {
+    // hold points generated ahead are enough, the window shrinks (but not below s hold points)
+    storageWindow->advance();
+  }
+  else {
+    storageWindow->update();
+
+    // hold points are generated in the same order as by fixed size window, so the trajectory doesn't change
+    while (*horizon > storageWindow->hardwareTimeEnd() &&
+           storageWindow->size() + properties.u() <= properties.sMax()) {
+      storageWindow->extend();
+    }
+  }
+
+  if (storageWindow->size() != previousSize) {
+    peakWindowSize = std::max(peakWindowSize, storageWindow->size());
+    windowSizeVector.record(storageWindow->size());
+  }
+}
+
+void SteinhauserClock::handleEngineUpdate()
+{
+  Enter_Method_Silent();
+
+  updateDisplay();
+
+  releaseTimers();
+  emit(windowUpdateSignal, getClockTimestamp());
+}
+
 void SteinhauserClock::finish()
 {
   if (storageWindow) {
     storageWindow->finish();
+
+    if (adaptiveWindow) {
+      recordScalar("storage_window_peak_size", peakWindowSize);
+    }
+  }
+
+  if (linearTrajectory) {
+    linearTrajectory->finish();
+  }
+
+  if (trajectoryRecorder) {
+    trajectoryRecorder->write(trajectoryCachePath);
   }
 }
 
+std::string SteinhauserClock::trajectoryCacheFileName() const
+{
+  std::string description = getNedTypeName();
+  description += '\n';
+  description += getFullPath();
+  description += '\n';
+  description += getEnvir()->getConfigEx()->getVariable(CFGVAR_SEEDSET);
+  description += '\n';
+  description += std::to_string(SimTime::getScaleExp());
+
+  for (int i = 0; i < getNumParams(); i++) {
+    const cPar& parameter = par(i);
+    if (strcmp(parameter.getName(), "trajectoryCacheDirectory") != 0) {
+      description += '\n';
+      description += parameter.getName();
+      description += '=';
+      description += parameter.str();
+    }
+  }
+
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%016llx.trajectory", static_cast<unsigned long long>(fnv1a(description)));
+  return buf;
+}
+
+bool SteinhauserClock::openTrajectoryCache(const std::string& directory)
+{
+  using namespace std::experimental;
+
+  filesystem::path path{directory};
+  try {
+    filesystem::create_directories(path);
+  }
+  catch (const filesystem::filesystem_error& error) {
+    throw cRuntimeError{"Cannot create directory \"%s\": %s", path.c_str(), error.what()};
+  }
+
+  path /= trajectoryCacheFileName();
+  trajectoryCachePath = path.string();
+
+  auto cache = TrajectoryCache::open(path, properties);
+  if (cache) {
+    // the key doesn't include the run length, cache has to cover the whole run (also unlimited one isn't covered)
+    const char* limit = getEnvir()->getConfigEx()->getConfigValue("sim-time-limit");
+    if (limit && SimTime::parse(limit) < cache->realTimeEnd()) {
+      EV << "using clock trajectory cache " << trajectoryCachePath << "\n";
+      trajectoryCache = cache.release();
+      return true;
+    }
+
+    EV << "clock trajectory cache " << trajectoryCachePath << " is shorter than the run, generating a new one\n";
+  }
+
+  trajectoryRecorder = new TrajectoryRecorder(properties);
+  return false;
+}
+
+VectorSummary* SteinhauserClock::createVectorSummary() const
+{
+  using namespace std::experimental;
+
+  const std::string mode = par("vectorRecording").stdstringValue();
+  if (mode == "full") {
+    return nullptr;
+  }
+  if (mode != "summary") {
+    throw cRuntimeError{"Invalid value of \"vectorRecording\" parameter: \"%s\"", mode.c_str()};
+  }
+
+  const int bucket = par("vectorBucket");
+  if (bucket < 1) {
+    throw cRuntimeError{"Parameter \"vectorBucket\" has to be positive"};
+  }
+
+  filesystem::path path{par("vectorSummaryDirectory").stdstringValue()};
+  try {
+    filesystem::create_directories(path);
+  }
+  catch (const filesystem::filesystem_error& error) {
+    throw cRuntimeError{"Cannot create directory \"%s\": %s", path.c_str(), error.what()};
+  }
+
+  cConfigurationEx* config = getEnvir()->getConfigEx();
+  std::string fileName = config->getVariable(CFGVAR_CONFIGNAME);
+  fileName += '-';
+  fileName += config->getVariable(CFGVAR_RUNNUMBER);
+  fileName += '-';
+  fileName += getFullPath();
+  fileName += ".vsum";
+  path /= fileName;
+
+  return new VectorSummary(bucket, path.string());
+}
+
 void SteinhauserClock::updateDisplay()
 {
   if (!getEnvir()->isGUI() || getEnvir()->isLoggingEnabled()) {
@@ -157,7 +424,7 @@ void SteinhauserClock::updateDisplay()
   }
 
   simtime_t real = simTime();
-  const simtime_t& hard = storageWindow->hardwareTimeBegin();
+  simtime_t hard = hardwareTimeBegin();
 
   simtime_t diff = hard - real;
   double d = fabs(diff.dbl());
@@ -197,9 +464,62 @@ void SteinhauserClock::updateDisplay()
   getDisplayString().setTagArg("t", 0, buf);
 }
 
+void SteinhauserClock::catchUp(const simtime_t& now)
+{
+  // periodic updates keep the current hold point among the first u ones
+  while (storageWindow->indexOf(now) >= properties.u()) {
+    storageWindow->advance();
+  }
+}
+
+simtime_t SteinhauserClock::hardwareTimeBegin() const
+{
+  if (engine) {
+    return engine->hardwareTimeBegin(engineIndex);
+  }
+  else if (trajectory) {
+    return trajectory->hardwareTimeBegin();
+  }
+  else if (trajectoryCache) {
+    const size_t current = trajectoryCache->indexOf(simTime());
+    return trajectoryCache->at(current - current % properties.u()).hardwareTime;
+  }
+  else if (linearTrajectory) {
+    return linearTrajectory->at(linearTrajectory->indexOf(simTime())).hardwareTime;
+  }
+
+  return storageWindow->hardwareTimeBegin();
+}
+
 omnetpp::SimTime SteinhauserClock::getClockTimestamp()
 {
+  if (engine) {
+    return engine->getClockTimestamp(engineIndex);
+  }
+  else if (trajectory) {
+    const simtime_t now = simTime();
+    const size_t k = trajectory->indexOf(now);
+    trajectory->discardBefore(k);
+
+    const StorageWindow::HoldPoint hp = trajectory->at(k);
+    return hp.hardwareTime + (now - hp.realTime) * (1 + hp.drift);
+  }
+  else if (trajectoryCache) {
+    const simtime_t now = simTime();
+    const StorageWindow::HoldPoint hp = trajectoryCache->at(trajectoryCache->indexOf(now));
+    return hp.hardwareTime + (now - hp.realTime) * (1 + hp.drift);
+  }
+  else if (linearTrajectory) {
+    const simtime_t now = simTime();
+    const StorageWindow::HoldPoint hp = linearTrajectory->at(linearTrajectory->indexOf(now));
+    return hp.hardwareTime + (now - hp.realTime) * (1 + hp.drift);
+  }
+
   const simtime_t now = simTime();
+  if (lazy) {
+    catchUp(now);
+  }
+
   const int k = storageWindow->indexOf(now);
   const StorageWindow::HoldPoint& hp = storageWindow->at(k);
   const simtime_t t = now - hp.realTime;
@@ -208,6 +528,52 @@ omnetpp::SimTime SteinhauserClock::getClockTimestamp()
 
 Clock::OptionalSimTime SteinhauserClock::convertToSimulationTimestamp(const omnetpp::SimTime& timestamp)
 {
+  if (engine) {
+    return engine->convertToSimulationTimestamp(engineIndex, timestamp);
+  }
+  else if (trajectory) {
+    const size_t current = trajectory->indexOf(simTime());
+    trajectory->discardBefore(current);
+
+    if (timestamp < trajectory->hardwareTimeBegin()) {
+      return {};
+    }
+
+    const StorageWindow::HoldPoint hp = trajectory->at(std::max(current, trajectory->hardwareIndexOf(timestamp)));
+    return hp.realTime + (timestamp - hp.hardwareTime) / (1 + hp.drift);
+  }
+  else if (trajectoryCache) {
+    // hold points before the beginning of the window that periodic updates would keep aren't used
+    if (timestamp < hardwareTimeBegin()) {
+      return {};
+    }
+
+    if (timestamp > trajectoryCache->hardwareTimeEnd()) {
+      // beyond the end of the run which recorded the cache
+      return {};
+    }
+
+    const size_t current = trajectoryCache->indexOf(simTime());
+    const size_t k = std::max(current, trajectoryCache->hardwareIndexOf(timestamp));
+    const StorageWindow::HoldPoint hp = trajectoryCache->at(k);
+    return hp.realTime + (timestamp - hp.hardwareTime) / (1 + hp.drift);
+  }
+  else if (linearTrajectory) {
+    // any timestamp can be converted, hold points are chosen the same way as in the storage window
+    const int64_t k = std::max(linearTrajectory->indexOf(simTime()), linearTrajectory->hardwareIndexOf(timestamp));
+    const StorageWindow::HoldPoint hp = linearTrajectory->at(k);
+    return hp.realTime + (timestamp - hp.hardwareTime) / (1 + hp.drift);
+  }
+
+  if (lazy) {
+    catchUp(simTime());
+
+    // generate hold points up to the requested timestamp
+    while (timestamp > storageWindow->hardwareTimeEnd()) {
+      storageWindow->extend();
+    }
+  }
+
   if (timestamp < storageWindow->at(0).hardwareTime || timestamp > storageWindow->hardwareTimeEnd()) {
     // outside of storage window, can't translate timestamp
     return {};
@@ -215,15 +581,51 @@ Clock::OptionalSimTime SteinhauserClock::convertToSimulationTimestamp(const omne
 
   // the current interval is the lower limit for the
   // interval the hardware time is in
+  const size_t k = std::max(storageWindow->indexOf(simTime()), storageWindow->hardwareIndexOf(timestamp));
+
+  return storageWindow->realTimeOf(k, timestamp);
+}
+
+size_t SteinhauserClock::convertToSimulationTimestamps(const std::vector<SimTime>& timestamps,
+                                                      std::vector<SimTime>& simulationTimestamps)
+{
+  simulationTimestamps.clear();
+
+  if (!storageWindow || lazy) {
+    // hold points aren't kept in a window, every timestamp is converted on its own
+    for (const auto& timestamp : timestamps) {
+      const auto simulationTimestamp = convertToSimulationTimestamp(timestamp);
+      if (!simulationTimestamp) {
+        break;
+      }
+      simulationTimestamps.push_back(*simulationTimestamp);
+    }
+
+    return simulationTimestamps.size();
+  }
+
+  // timestamps are sorted, so the hold point of each one is found by walking forward from the
+  // previous one, starting at the current interval (the lower limit, as in convertToSimulationTimestamp())
+  const size_t last = storageWindow->size() - 1;
   size_t k = storageWindow->indexOf(simTime());
+  for (const auto& timestamp : timestamps) {
+    if (timestamp < storageWindow->at(0).hardwareTime || timestamp > storageWindow->hardwareTimeEnd()) {
+      break;
+    }
+
+    while (k != last && storageWindow->at(k + 1).hardwareTime < timestamp) {
+      k++;
+    }
 
-  // find the correct interval
-  while (k != properties.s() - 1 && storageWindow->at(k + 1).hardwareTime < timestamp) {
-    k++;
+    simulationTimestamps.push_back(storageWindow->realTimeOf(k, timestamp));
   }
 
-  const StorageWindow::HoldPoint& hp = storageWindow->at(k);
-  return hp.realTime + (timestamp - hp.hardwareTime) / (1 + hp.drift);
+  return simulationTimestamps.size();
+}
+
+const StorageWindow* SteinhauserClock::getStorageWindow() const
+{
+  return storageWindow;
 }
 
 }  // namespace steinhauser_clock
@@ -37,13 +37,20 @@
 #pragma once
 
 #include <omnetpp.h>
+#include <string>
 #include "Clock.h"
 
 namespace smile {
 namespace steinhauser_clock {
 
 class SteinhauserClock;
+class LinearTrajectory;
+class SeekableTrajectory;
+class SteinhauserClockEngine;
 class StorageWindow;
+class TrajectoryCache;
+class TrajectoryRecorder;
+class VectorSummary;
 
 /// \brief Implementation of a hardware (real, non perfect) clock.
 ///
@@ -65,6 +72,9 @@ class SteinhauserClock : public Clock
     /// storage window size (in # of tints)
     size_t _s{0};
 
+    /// upper bound of adaptive storage window size (in # of tints)
+    size_t _sMax{0};
+
    public:
     Properties() = default;
 
@@ -89,6 +99,14 @@ class SteinhauserClock : public Clock
       return _s;
     }
 
+    /// \returns	The upper bound of the storage window size if the window
+    ///		adapts to pending timers, equal to s() otherwise
+    ///		(measured in number of times of tint).
+    size_t sMax() const
+    {
+      return _sMax;
+    }
+
     /// \returns	The time between two updates of the storage window.
     omnetpp::simtime_t updateInterval() const
     {
@@ -97,11 +115,14 @@ class SteinhauserClock : public Clock
 
     /// Sets the values that are held in the object.
     ///
-    /// s is set to twice the value of u.
+    /// s is set to twice the value of u. sMax is rounded up to a
+    /// multiple of u and is at least s.
     ///
     /// \param tint	The new value for the time between two hold points.
     /// \param u	The new value for the length of the update interval.
-    void set(const omnetpp::simtime_t& tint, size_t u);
+    /// \param sMax	The new value for the upper bound of the storage window
+    ///		size, 0 keeps the size fixed.
+    void set(const omnetpp::simtime_t& tint, size_t u, size_t sMax = 0);
   };
 
  private:
@@ -110,9 +131,55 @@ class SteinhauserClock : public Clock
 
   StorageWindow* storageWindow{nullptr};
 
+  /// Trajectory used instead of the storage window by counter-based clocks.
+  SeekableTrajectory* trajectory{nullptr};
+
+  /// Closed form trajectory used instead of the storage window by constant drift clocks.
+  LinearTrajectory* linearTrajectory{nullptr};
+
+  /// Trajectory mapped from a cache file written by a previous run.
+  TrajectoryCache* trajectoryCache{nullptr};
+
+  /// Collects hold points to be written to the cache file at the end of the run.
+  TrajectoryRecorder* trajectoryRecorder{nullptr};
+
+  /// Path of the trajectory cache file written by trajectoryRecorder.
+  std::string trajectoryCachePath;
+
+  /// Engine holding the storage window if "engineModule" parameter is set.
+  SteinhauserClockEngine* engine{nullptr};
+
+  /// Index of this clock in the engine.
+  size_t engineIndex{0};
+
   /// Message to schedule storage window updates.
   omnetpp::cMessage* selfMsg{nullptr};
 
+  /// If set, the storage window is updated and extended on demand
+  /// instead of periodic self messages.
+  bool lazy{false};
+
+  /// Brings the storage window to the state it would have at simulation time now
+  /// with periodic updates (used in lazy mode).
+  void catchUp(const omnetpp::simtime_t& now);
+
+  /// If set, the storage window grows up to sMax hold points to cover clock timestamps
+  /// of pending timers and shrinks back to s hold points when they are released.
+  bool adaptiveWindow{false};
+
+  /// Vector to record the storage window size (in hold points).
+  omnetpp::cOutVector windowSizeVector;
+
+  /// Vector to record the number of timers that couldn't be released after an update.
+  omnetpp::cOutVector timersBeyondWindowVector;
+
+  /// The largest storage window size (in hold points).
+  size_t peakWindowSize{0};
+
+  /// Updates the storage window by u hold points. In adaptive mode new hold points are
+  /// generated only up to the furthest clock timestamp of pending timers.
+  void updateStorageWindow();
+
   /// Schedules the next update of the storage window.
   ///
   /// \param msg	The message used as a self message.
@@ -122,6 +189,24 @@ class SteinhauserClock : public Clock
   /// between different simulation runs.
   void cleanup();
 
+  /// Returns the hardware time at the beginning of the kept hold points.
+  omnetpp::simtime_t hardwareTimeBegin() const;
+
+  /// Calculates the name of the trajectory cache file from the hash of clock's
+  /// parameters, path in the network and seed set.
+  std::string trajectoryCacheFileName() const;
+
+  /// Maps the trajectory cache file or prepares the recorder if the file doesn't exist yet.
+  ///
+  /// \returns	True if the file was mapped.
+  bool openTrajectoryCache(const std::string& directory);
+
+  /// Creates the summary replacing vectors of the storage window according to the
+  /// "vectorRecording" parameter.
+  ///
+  /// \returns	The summary, or nullptr if full resolution vectors are recorded.
+  VectorSummary* createVectorSummary() const;
+
   /// Updates the text shown to the user in the GUI.
   void updateDisplay();
 
@@ -134,6 +219,11 @@ class SteinhauserClock : public Clock
   /// Writes out statistics.
   void finish() override;
 
+  /// Called by the engine after storage windows were updated.
+  void handleEngineUpdate();
+
+  friend class SteinhauserClockEngine;
+
  public:
   /// Initializes the hardware clock.
   SteinhauserClock() = default;
@@ -144,6 +234,12 @@ class SteinhauserClock : public Clock
   omnetpp::SimTime getClockTimestamp() override;
 
   OptionalSimTime convertToSimulationTimestamp(const omnetpp::SimTime& timestamp) override;
+  size_t convertToSimulationTimestamps(const std::vector<omnetpp::SimTime>& timestamps,
+                                       std::vector<omnetpp::SimTime>& simulationTimestamps) override;
+
+  /// \returns	The storage window holding the current hold points, or nullptr
+  ///		if hold points are kept by a SteinhauserClockEngine or the clock is counter-based.
+  const StorageWindow* getStorageWindow() const;
 };
 
 }  // namespace steinhauser_clock
@@ -0,0 +1,195 @@
+//
+// Copyright (C) 2018 Tomasz Jankowski <t.jankowski AT pwr.edu.pl>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "SteinhauserClockEngine.h"
+#include <inet/common/INETDefs.h>
+#include <algorithm>
+#include "DriftSource.h"
+
+using namespace omnetpp;
+
+namespace smile {
+namespace steinhauser_clock {
+
+Define_Module(SteinhauserClockEngine);
+
+SteinhauserClockEngine::~SteinhauserClockEngine()
+{
+  cancelAndDelete(updateMessage);
+}
+
+void SteinhauserClockEngine::initialize(int stage)
+{
+  // clocks register in INITSTAGE_LOCAL, updates are scheduled once all of them are known
+  if (stage == inet::INITSTAGE_LOCAL + 1 && !clocks.empty()) {
+    EV << "update interval: " << properties.updateInterval() << "s, clocks: " << clocks.size() << "\n";
+
+    updateMessage = new cMessage("storage windows update");
+    scheduleAt(simTime() + properties.updateInterval(), updateMessage);
+  }
+}
+
+int SteinhauserClockEngine::numInitStages() const
+{
+  return inet::INITSTAGE_LOCAL + 2;
+}
+
+void SteinhauserClockEngine::handleMessage(cMessage* message)
+{
+  if (message != updateMessage) {
+    throw cRuntimeError{"Received unexpected message \"%s\"", message->getFullName()};
+  }
+
+  update();
+  scheduleAt(simTime() + properties.updateInterval(), updateMessage);
+}
+
+size_t SteinhauserClockEngine::registerClock(SteinhauserClock* clock,
+                                             const SteinhauserClock::Properties& clockProperties, DriftSource* source)
+{
+  std::unique_ptr<DriftSource> driftSource{source};
+  const simtime_t now = simTime();
+
+  if (updateMessage) {
+    throw cRuntimeError{"Clocks have to be registered in SteinhauserClockEngine during initialization"};
+  }
+
+  if (clocks.empty()) {
+    properties = clockProperties;
+    realTimes.resize(properties.s());
+    driftBuffer.resize(properties.s());
+
+    realTimes[0] = now;
+    for (size_t i = 1; i < realTimes.size(); i++) {
+      realTimes[i] = realTimes[i - 1] + properties.tint();
+    }
+  }
+  else if (clockProperties.tint() != properties.tint() || clockProperties.u() != properties.u()) {
+    throw cRuntimeError{"All clocks registered in SteinhauserClockEngine have to use the same interval and update"};
+  }
+
+  const size_t clockIndex = clocks.size();
+  const size_t base = clockIndex * properties.s();
+
+  clocks.push_back(clock);
+  hardwareTimes.resize(base + properties.s());
+  drifts.resize(base + properties.s());
+  hardwareTimeEnds.emplace_back();
+
+  hardwareTimes[base] = now;
+  drifts[base] = driftSource->nextValue();
+  sources.push_back(std::move(driftSource));
+
+  fillRange(clockIndex, 1, properties.s());
+  return clockIndex;
+}
+
+void SteinhauserClockEngine::update()
+{
+  const size_t s = properties.s();
+  const size_t u = properties.u();
+
+  // the first u hold points slide out of all windows, their slots are reused for the new ones
+  head = slot(u);
+
+  for (size_t i = s - u; i < s; i++) {
+    realTimes[slot(i)] = realTimes[slot(i - 1)] + properties.tint();
+  }
+
+  for (size_t clockIndex = 0; clockIndex < clocks.size(); clockIndex++) {
+    fillRange(clockIndex, s - u, s);
+  }
+
+  for (auto clock : clocks) {
+    clock->handleEngineUpdate();
+  }
+}
+
+void SteinhauserClockEngine::fillRange(size_t clockIndex, size_t first, size_t last)
+{
+  simtime_t* hardwareTime = &hardwareTimes[clockIndex * properties.s()];
+  double* drift = &drifts[clockIndex * properties.s()];
+
+  sources[clockIndex]->fillValues(driftBuffer.data(), last - first);
+
+  for (std::vector<double>::const_iterator value = driftBuffer.begin(); first != last; first++, value++) {
+    const size_t pre = slot(first - 1);
+    const size_t current = slot(first);
+
+    hardwareTime[current] = hardwareTime[pre] + properties.tint() * (1 + drift[pre]);
+    drift[current] = *value;
+  }
+
+  const size_t lastSlot = slot(properties.s() - 1);
+  hardwareTimeEnds[clockIndex] = hardwareTime[lastSlot] + properties.tint() * (1 + drift[lastSlot]);
+}
+
+size_t SteinhauserClockEngine::indexOf(const simtime_t& t) const
+{
+  return (t - realTimes[head]) / properties.tint();
+}
+
+size_t SteinhauserClockEngine::hardwareIndexOf(size_t clockIndex, const simtime_t& t) const
+{
+  const simtime_t* hardwareTime = &hardwareTimes[clockIndex * properties.s()];
+
+  // number of hold points with hardware time lower than t
+  size_t first = 0;
+  size_t count = properties.s();
+  while (count > 0) {
+    const size_t step = count / 2;
+    if (hardwareTime[slot(first + step)] < t) {
+      first += step + 1;
+      count -= step + 1;
+    }
+    else {
+      count = step;
+    }
+  }
+
+  return first > 0 ? first - 1 : 0;
+}
+
+SimTime SteinhauserClockEngine::getClockTimestamp(size_t clockIndex) const
+{
+  const simtime_t now = simTime();
+  const size_t k = slot(indexOf(now));
+  const size_t idx = clockIndex * properties.s() + k;
+  return hardwareTimes[idx] + (now - realTimes[k]) * (1 + drifts[idx]);
+}
+
+IClock::OptionalSimTime SteinhauserClockEngine::convertToSimulationTimestamp(size_t clockIndex,
+                                                                             const SimTime& timestamp) const
+{
+  if (timestamp < hardwareTimeBegin(clockIndex) || timestamp > hardwareTimeEnds[clockIndex]) {
+    // outside of storage window, can't translate timestamp
+    return {};
+  }
+
+  // the current interval is the lower limit for the interval the hardware time is in
+  const size_t k = slot(std::max(indexOf(simTime()), hardwareIndexOf(clockIndex, timestamp)));
+  const size_t idx = clockIndex * properties.s() + k;
+  return realTimes[k] + (timestamp - hardwareTimes[idx]) / (1 + drifts[idx]);
+}
+
+const SimTime& SteinhauserClockEngine::hardwareTimeBegin(size_t clockIndex) const
+{
+  return hardwareTimes[clockIndex * properties.s() + head];
+}
+
+}  // namespace steinhauser_clock
+}  // namespace smile
@@ -0,0 +1,125 @@
+//
+// Copyright (C) 2018 Tomasz Jankowski <t.jankowski AT pwr.edu.pl>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#pragma once
+
+#include <omnetpp.h>
+#include <memory>
+#include <vector>
+#include "IClock.h"
+#include "SteinhauserClock.h"
+
+namespace smile {
+namespace steinhauser_clock {
+
+class DriftSource;
+
+/// \brief Network-level engine holding storage windows of many Steinhauser clocks.
+///
+/// SteinhauserClock modules with "engineModule" parameter set register with the
+/// engine instead of creating their own StorageWindow. The engine keeps hold points
+/// of all registered clocks in contiguous structure-of-arrays buffers and advances all
+/// windows in a single event per update interval. All registered clocks have to share
+/// the same interval and update values, so they also share simulation times of hold points.
+class SteinhauserClockEngine : public omnetpp::cSimpleModule
+{
+ public:
+  SteinhauserClockEngine() = default;
+  SteinhauserClockEngine(const SteinhauserClockEngine& source) = delete;
+  SteinhauserClockEngine(SteinhauserClockEngine&& source) = delete;
+  ~SteinhauserClockEngine() override;
+
+  SteinhauserClockEngine& operator=(const SteinhauserClockEngine& source) = delete;
+  SteinhauserClockEngine& operator=(SteinhauserClockEngine&& source) = delete;
+
+  /// Registers a clock and fills its storage window.
+  ///
+  /// Clocks have to be registered during initialization.
+  /// \param clock	The clock notified whenever storage windows are updated.
+  /// \param clockProperties	Properties of the registered clock.
+  /// \param source	Source of drift values, the engine takes ownership of it.
+  /// \returns	Index of the clock used in the remaining calls.
+  size_t registerClock(SteinhauserClock* clock, const SteinhauserClock::Properties& clockProperties,
+                       DriftSource* source);
+
+  /// \returns	The hardware time of the clock at the current simulation time.
+  omnetpp::SimTime getClockTimestamp(size_t clockIndex) const;
+
+  /// \returns	The simulation time at which the clock reaches the hardware timestamp, or
+  ///		nothing if the timestamp lies outside of the storage window.
+  IClock::OptionalSimTime convertToSimulationTimestamp(size_t clockIndex, const omnetpp::SimTime& timestamp) const;
+
+  /// \returns	The hardware time at the beginning of the clock's storage window.
+  const omnetpp::SimTime& hardwareTimeBegin(size_t clockIndex) const;
+
+ private:
+  void initialize(int stage) override;
+
+  int numInitStages() const override;
+
+  void handleMessage(omnetpp::cMessage* message) override;
+
+  /// Maps a logical hold point index to its position in a storage window.
+  size_t slot(size_t idx) const
+  {
+    const size_t position = head + idx;
+    return position < properties.s() ? position : position - properties.s();
+  }
+
+  /// \returns	The index of the hold point in which the simulation time lies.
+  size_t indexOf(const omnetpp::simtime_t& t) const;
+
+  /// \returns	The index of the last hold point of the clock whose hardware time is
+  ///		lower than t, or 0 if there is no such hold point.
+  size_t hardwareIndexOf(size_t clockIndex, const omnetpp::simtime_t& t) const;
+
+  /// Fills the logical index range [first, last) of the clock's storage window.
+  void fillRange(size_t clockIndex, size_t first, size_t last);
+
+  /// Slides all storage windows by u hold points and notifies registered clocks.
+  void update();
+
+  /// Properties shared by all registered clocks.
+  SteinhauserClock::Properties properties;
+
+  /// Position of the first hold point (logical index 0) in every storage window.
+  size_t head{0};
+
+  /// Simulation times of hold points, common to all clocks (s elements).
+  std::vector<omnetpp::simtime_t> realTimes;
+
+  /// Hardware times of hold points, s consecutive elements per clock.
+  std::vector<omnetpp::simtime_t> hardwareTimes;
+
+  /// Drift values of hold points, s consecutive elements per clock.
+  std::vector<double> drifts;
+
+  /// Hardware timestamps of the first point after each storage window.
+  std::vector<omnetpp::simtime_t> hardwareTimeEnds;
+
+  std::vector<std::unique_ptr<DriftSource>> sources;
+  std::vector<SteinhauserClock*> clocks;
+
+  /// Buffer for drift values generated by a single refill.
+  std::vector<double> driftBuffer;
+
+  /// Message to schedule storage windows updates.
+  omnetpp::cMessage* updateMessage{nullptr};
+};
+
+}  // namespace steinhauser_clock
+}  // namespace smile
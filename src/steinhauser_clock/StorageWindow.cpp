@@ -37,19 +37,24 @@
 #include "StorageWindow.h"
 #include <exception>
 #include "DriftSource.h"
+#include "TrajectoryCache.h"
+#include "VectorSummary.h"
 
 using namespace omnetpp;
 
 namespace smile {
 namespace steinhauser_clock {
 
-StorageWindow::StorageWindow(const SteinhauserClock::Properties& properties, DriftSource* source) :
+StorageWindow::StorageWindow(const SteinhauserClock::Properties& properties, DriftSource* source,
+                             TrajectoryRecorder* recorder, VectorSummary* summary) :
     properties(properties),
-    source(source)
+    source(source),
+    recorder(recorder),
+    summary(summary)
 {
   data.resize(properties.s());
-
-  std::vector<HoldPoint>::iterator it = data.begin();
+  drifts.resize(properties.s());
+  length = properties.s();
 
   driftVector.setName("drift");
   timeVector.setName("hardware_time");
@@ -61,53 +66,101 @@ StorageWindow::StorageWindow(const SteinhauserClock::Properties& properties, Dri
 
   simtime_t now = simTime();
 
-  it->realTime = now;
-  it->hardwareTime = now;
-  it->drift = source->nextValue();
+  HoldPoint& first = data[head];
+  first.realTime = now;
+  first.hardwareTime = now;
+  first.drift = source->nextValue();
 
-  recordVectors(now, now, it->drift);
+  recordVectors(now, now, first.drift);
+  if (recorder) {
+    recorder->append(first);
+  }
 
-  fillRange(it + 1, data.end());
+  fillRange(1, length);
 }
 
 StorageWindow::~StorageWindow()
 {
   delete source;
+  delete summary;
 }
 
 void StorageWindow::finish()
 {
   driftHistogram.recordAs("drift_distribution");
+
+  if (summary) {
+    summary->finish();
+  }
 }
 
 void StorageWindow::update()
 {
-  data = std::vector<HoldPoint>(data.begin() + properties.u(), data.end());
-  data.resize(properties.s());
+  // the first u hold points slide out of the window, their slots are reused for the new ones
+  head = slot(properties.u());
+
+  fillRange(length - properties.u(), length);
+}
+
+void StorageWindow::advance()
+{
+  if (length - properties.u() < properties.s()) {
+    update();
+    return;
+  }
 
-  fillRange(data.begin() + (properties.s() - properties.u()), data.end());
+  // enough hold points were generated ahead, only discard the first u ones
+  head = slot(properties.u());
+  length -= properties.u();
 }
 
-void StorageWindow::fillRange(std::vector<HoldPoint>::iterator first, std::vector<HoldPoint>::iterator last)
+void StorageWindow::extend()
 {
-  while (first != last) {
-    std::vector<HoldPoint>::iterator pre = first - 1;
+  if (length + properties.u() > data.size()) {
+    // out of free slots, move hold points to a larger buffer starting at position 0
+    std::vector<HoldPoint> grown(2 * data.size());
+    for (size_t i = 0; i < length; i++) {
+      grown[i] = data[slot(i)];
+    }
+
+    data.swap(grown);
+    head = 0;
+  }
 
-    first->realTime = pre->realTime + properties.tint();
-    first->hardwareTime = pre->hardwareTime + properties.tint() * (1 + pre->drift);
-    first->drift = source->nextValue();
-    recordVectors(first->realTime, first->hardwareTime, first->drift);
+  length += properties.u();
+  fillRange(length - properties.u(), length);
+}
 
-    first++;
+void StorageWindow::fillRange(size_t first, size_t last)
+{
+  source->fillValues(drifts.data(), last - first);
+
+  for (std::vector<double>::const_iterator drift = drifts.begin(); first != last; first++, drift++) {
+    const HoldPoint& pre = data[slot(first - 1)];
+    HoldPoint& current = data[slot(first)];
+
+    current.realTime = pre.realTime + properties.tint();
+    current.hardwareTime = pre.hardwareTime + properties.tint() * (1 + pre.drift);
+    current.drift = *drift;
+    recordVectors(current.realTime, current.hardwareTime, current.drift);
+    if (recorder) {
+      recorder->append(current);
+    }
   }
 
-  _hardwareTimeEnd = data[data.size() - 1].hardwareTime + properties.tint() * (1 + data[data.size() - 1].drift);
+  const HoldPoint& lastPoint = data[slot(length - 1)];
+  _hardwareTimeEnd = lastPoint.hardwareTime + properties.tint() * (1 + lastPoint.drift);
 }
 
 void StorageWindow::recordVectors(const simtime_t& realTime, const simtime_t& hardwareTime, double drift)
 {
   driftHistogram.collect(drift);
 
+  if (summary) {
+    summary->collect(realTime, drift, (hardwareTime - realTime).dbl());
+    return;
+  }
+
   driftVector.recordWithTimestamp(realTime, drift);
   timeVector.recordWithTimestamp(realTime, hardwareTime);
   deviationVector.recordWithTimestamp(realTime, hardwareTime - realTime);
@@ -115,16 +168,35 @@ void StorageWindow::recordVectors(const simtime_t& realTime, const simtime_t& ha
 
 const StorageWindow::HoldPoint& StorageWindow::at(size_t idx) const
 {
-  if (idx > data.size() - 1) {
+  if (idx > length - 1) {
     throw std::logic_error("StorageWindow::HoldPoint: index out of bounds");
   }
 
-  return data[idx];
+  return data[slot(idx)];
 }
 
 size_t StorageWindow::indexOf(const simtime_t& t) const
 {
-  return (t - data[0].realTime) / properties.tint();
+  return (t - data[head].realTime) / properties.tint();
+}
+
+size_t StorageWindow::hardwareIndexOf(const simtime_t& t) const
+{
+  // number of hold points with hardware time lower than t
+  size_t first = 0;
+  size_t count = length;
+  while (count > 0) {
+    const size_t step = count / 2;
+    if (data[slot(first + step)].hardwareTime < t) {
+      first += step + 1;
+      count -= step + 1;
+    }
+    else {
+      count = step;
+    }
+  }
+
+  return first > 0 ? first - 1 : 0;
 }
 
 }  // namespace steinhauser_clock
@@ -43,6 +43,8 @@ namespace smile {
 namespace steinhauser_clock {
 
 class DriftSource;
+class TrajectoryRecorder;
+class VectorSummary;
 
 /// Saves the data points for the continuous linear approximation of the drift function.
 class StorageWindow
@@ -63,8 +65,18 @@ class StorageWindow
 
  private:
   /// Holds the data of the approximation.
+  ///
+  /// The vector is allocated once with s elements and used as a circular
+  /// buffer, the hold point with logical index 0 is stored at data[head].
+  /// It only grows when the window is extended by extend().
   std::vector<HoldPoint> data;
 
+  /// Position of the first hold point (logical index 0) in the data vector.
+  size_t head{0};
+
+  /// The number of hold points in the storage window.
+  size_t length{0};
+
   /// The properties of the clock this object belongs to.
   const SteinhauserClock::Properties& properties;
 
@@ -72,6 +84,15 @@ class StorageWindow
   /// the data vector.
   DriftSource* source{nullptr};
 
+  /// Buffer for drift values generated by a single refill.
+  std::vector<double> drifts;
+
+  /// Optional recorder of all generated hold points.
+  TrajectoryRecorder* recorder{nullptr};
+
+  /// Optional summary recorded instead of the vectors.
+  VectorSummary* summary{nullptr};
+
   /// Vector to record the drift values.
   omnetpp::cOutVector driftVector;
 
@@ -89,10 +110,17 @@ class StorageWindow
   /// storage window.
   omnetpp::simtime_t _hardwareTimeEnd;
 
-  /// Fills the range [first, last) with new timestamp/drift values.
-  void fillRange(std::vector<HoldPoint>::iterator first, std::vector<HoldPoint>::iterator last);
+  /// Maps a logical hold point index to its position in the data vector.
+  size_t slot(size_t idx) const
+  {
+    const size_t position = head + idx;
+    return position < data.size() ? position : position - data.size();
+  }
+
+  /// Fills the logical index range [first, last) with new timestamp/drift values.
+  void fillRange(size_t first, size_t last);
 
-  /// Records the given values to the vector files.
+  /// Records the given values to the vector files or to the summary, if set.
   ///
   /// \param realTime	The simulation timestamp, also used to calculate the time deviation.
   ///			Has to be increasing between two calls to the function.
@@ -107,7 +135,12 @@ class StorageWindow
   ///			to determine things like the length of the storage window, etc.
   /// \param source	Pointer to a source of drift values, the StorageWindow object
   ///			takes ownership of the object being passed.
-  StorageWindow(const SteinhauserClock::Properties& properties, DriftSource* source);
+  /// \param recorder	Optional recorder receiving every generated hold point, the
+  ///			StorageWindow object doesn't take ownership of it.
+  /// \param summary	Optional summary replacing drift, hardware time and time deviation
+  ///			vectors, the StorageWindow object takes ownership of the object being passed.
+  StorageWindow(const SteinhauserClock::Properties& properties, DriftSource* source,
+                TrajectoryRecorder* recorder = nullptr, VectorSummary* summary = nullptr);
 
   ~StorageWindow();
 
@@ -117,14 +150,24 @@ class StorageWindow
   /// Updates the storage window.
   ///
   /// The first u values in the storge window are discarded, the
-  /// remaining ones are moved to the front and the empty space
-  /// is filled up with new values.
+  /// remaining ones become the front of the window and the freed
+  /// slots are filled up with new values. No memory is allocated.
   void update();
 
+  /// Moves the beginning of the storage window by u hold points.
+  ///
+  /// New hold points are generated only if the window would get shorter than
+  /// s hold points, otherwise the ones generated by extend() are used.
+  void advance();
+
+  /// Extends the storage window by u new hold points, the first hold points
+  /// are kept. The storage may be reallocated.
+  void extend();
+
   /// Returns the time at the beginning of the storage window.
   const omnetpp::simtime_t& hardwareTimeBegin() const
   {
-    return data[0].hardwareTime;
+    return data[head].hardwareTime;
   }
 
   /// Returns the time at the end of the storage window.
@@ -133,6 +176,12 @@ class StorageWindow
     return _hardwareTimeEnd;
   }
 
+  /// Returns the number of hold points in the storage window.
+  size_t size() const
+  {
+    return length;
+  }
+
   /// Returns the hold point at index idx.
   ///
   /// If the index is out of bounds, an std::logic_error exception is thrown.
@@ -145,6 +194,26 @@ class StorageWindow
   /// \param t	A simulation timestamp.
   /// \returns	The index of the hold point in what the simulation time lies.
   size_t indexOf(const omnetpp::simtime_t& t) const;
+
+  /// Converts a hardware timestamp to simulation time on the segment of a hold point.
+  ///
+  /// \param idx	The index of the hold point.
+  /// \param hardwareTime	A hardware timestamp.
+  /// \returns	The simulation time at which the segment reaches hardwareTime.
+  omnetpp::simtime_t realTimeOf(size_t idx, const omnetpp::simtime_t& hardwareTime) const
+  {
+    const HoldPoint& hp = data[slot(idx)];
+    return hp.realTime + (hardwareTime - hp.hardwareTime) / (1 + hp.drift);
+  }
+
+  /// Calculates the hold point index for a hardware timestamp.
+  ///
+  /// Hardware times of the hold points are strictly increasing, so
+  /// the index is found with a binary search.
+  /// \param t	A hardware timestamp.
+  /// \returns	The index of the last hold point whose hardware time is
+  ///		lower than t, or 0 if there is no such hold point.
+  size_t hardwareIndexOf(const omnetpp::simtime_t& t) const;
 };
 
 }  // namespace steinhauser_clock
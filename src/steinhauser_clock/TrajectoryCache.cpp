@@ -0,0 +1,185 @@
+//
+// Copyright (C) 2018 Tomasz Jankowski <t.jankowski AT pwr.edu.pl>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "TrajectoryCache.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+
+using namespace omnetpp;
+
+namespace smile {
+namespace steinhauser_clock {
+
+namespace {
+
+const char fileMagic[8] = {'S', 'M', 'I', 'L', 'E', 'T', 'R', 'J'};
+const uint32_t fileVersion = 1;
+
+struct FileHeader
+{
+  char magic[8];
+  uint32_t version;
+  int32_t scaleExponent;
+  int64_t tint;
+  uint64_t u;
+  int64_t realTimeBegin;
+  uint64_t count;
+};
+
+}  // namespace
+
+TrajectoryRecorder::TrajectoryRecorder(const SteinhauserClock::Properties& properties) : properties(properties) {}
+
+void TrajectoryRecorder::append(const StorageWindow::HoldPoint& hp)
+{
+  if (hardwareTimes.empty()) {
+    realTimeBegin = hp.realTime;
+  }
+
+  hardwareTimes.push_back(hp.hardwareTime.raw());
+  drifts.push_back(hp.drift);
+}
+
+void TrajectoryRecorder::write(const std::experimental::filesystem::path& path) const
+{
+  FileHeader header;
+  std::memcpy(header.magic, fileMagic, sizeof(fileMagic));
+  header.version = fileVersion;
+  header.scaleExponent = SimTime::getScaleExp();
+  header.tint = properties.tint().raw();
+  header.u = properties.u();
+  header.realTimeBegin = realTimeBegin.raw();
+  header.count = hardwareTimes.size();
+
+  auto temporaryPath = path;
+  temporaryPath += "." + std::to_string(getpid()) + ".tmp";
+
+  try {
+    std::ofstream stream;
+    stream.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+    stream.open(temporaryPath, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(hardwareTimes.data()), hardwareTimes.size() * sizeof(int64_t));
+    stream.write(reinterpret_cast<const char*>(drifts.data()), drifts.size() * sizeof(double));
+    stream.close();
+
+    std::experimental::filesystem::rename(temporaryPath, path);
+  }
+  catch (const std::ios_base::failure& error) {
+    throw cRuntimeError{"Failed to write clock trajectory cache \"%s\": %s", temporaryPath.c_str(), error.what()};
+  }
+  catch (const std::experimental::filesystem::filesystem_error& error) {
+    throw cRuntimeError{"Failed to write clock trajectory cache \"%s\": %s", path.c_str(), error.what()};
+  }
+}
+
+TrajectoryCache::~TrajectoryCache()
+{
+  if (mapping) {
+    munmap(mapping, mappingSize);
+  }
+}
+
+std::unique_ptr<TrajectoryCache> TrajectoryCache::open(const std::experimental::filesystem::path& path,
+                                                       const SteinhauserClock::Properties& properties)
+{
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    if (errno == ENOENT) {
+      return nullptr;
+    }
+
+    throw cRuntimeError{"Failed to open clock trajectory cache \"%s\": %s", path.c_str(), std::strerror(errno)};
+  }
+
+  struct stat status;
+  if (fstat(fd, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(FileHeader)) {
+    ::close(fd);
+    throw cRuntimeError{"Invalid clock trajectory cache \"%s\"", path.c_str()};
+  }
+
+  std::unique_ptr<TrajectoryCache> cache{new TrajectoryCache};
+  cache->mappingSize = status.st_size;
+  cache->mapping = mmap(nullptr, cache->mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+
+  if (cache->mapping == MAP_FAILED) {
+    cache->mapping = nullptr;
+    throw cRuntimeError{"Failed to map clock trajectory cache \"%s\": %s", path.c_str(), std::strerror(errno)};
+  }
+
+  const auto& header = *static_cast<const FileHeader*>(cache->mapping);
+  const auto expectedSize = sizeof(FileHeader) + header.count * (sizeof(int64_t) + sizeof(double));
+  if (std::memcmp(header.magic, fileMagic, sizeof(fileMagic)) != 0 || header.version != fileVersion ||
+      header.scaleExponent != SimTime::getScaleExp() || header.tint != properties.tint().raw() ||
+      header.u != properties.u() || header.count == 0 || expectedSize != cache->mappingSize) {
+    throw cRuntimeError{"Clock trajectory cache \"%s\" doesn't match the clock", path.c_str()};
+  }
+
+  const char* data = static_cast<const char*>(cache->mapping) + sizeof(FileHeader);
+  cache->properties = &properties;
+  cache->count = header.count;
+  cache->realTimeBegin.setRaw(header.realTimeBegin);
+  cache->hardwareTimes = reinterpret_cast<const int64_t*>(data);
+  cache->drifts = reinterpret_cast<const double*>(data + header.count * sizeof(int64_t));
+  return cache;
+}
+
+StorageWindow::HoldPoint TrajectoryCache::at(size_t k) const
+{
+  if (k >= count) {
+    throw cRuntimeError{"Clock trajectory cache is too short, remove it to generate a longer one"};
+  }
+
+  // simulation times are sums of tint, so they can be computed exactly
+  StorageWindow::HoldPoint hp;
+  hp.realTime.setRaw(realTimeBegin.raw() + static_cast<int64_t>(k) * properties->tint().raw());
+  hp.hardwareTime.setRaw(hardwareTimes[k]);
+  hp.drift = drifts[k];
+  return hp;
+}
+
+size_t TrajectoryCache::indexOf(const simtime_t& t) const
+{
+  return (t - realTimeBegin) / properties->tint();
+}
+
+size_t TrajectoryCache::hardwareIndexOf(const simtime_t& t) const
+{
+  const auto first = std::lower_bound(hardwareTimes, hardwareTimes + count, t.raw()) - hardwareTimes;
+  return first > 0 ? first - 1 : 0;
+}
+
+simtime_t TrajectoryCache::hardwareTimeEnd() const
+{
+  const StorageWindow::HoldPoint last = at(count - 1);
+  return last.hardwareTime + properties->tint() * (1 + last.drift);
+}
+
+simtime_t TrajectoryCache::realTimeEnd() const
+{
+  return SimTime::fromRaw(realTimeBegin.raw() + static_cast<int64_t>(count) * properties->tint().raw());
+}
+
+}  // namespace steinhauser_clock
+}  // namespace smile
@@ -0,0 +1,119 @@
+//
+// Copyright (C) 2018 Tomasz Jankowski <t.jankowski AT pwr.edu.pl>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#pragma once
+
+#include <omnetpp.h>
+#include <cstdint>
+#include <experimental/filesystem>
+#include <memory>
+#include <vector>
+#include "StorageWindow.h"
+
+namespace smile {
+namespace steinhauser_clock {
+
+/// Collects hold points of a running clock and writes them as a cache file.
+class TrajectoryRecorder
+{
+ public:
+  TrajectoryRecorder(const SteinhauserClock::Properties& properties);
+
+  /// Appends the next hold point, hold points have to be appended in order.
+  void append(const StorageWindow::HoldPoint& hp);
+
+  /// Writes collected hold points to the file.
+  ///
+  /// The file is written under a temporary name and renamed, so concurrent
+  /// runs never map an incomplete file.
+  void write(const std::experimental::filesystem::path& path) const;
+
+ private:
+  const SteinhauserClock::Properties& properties;
+  omnetpp::simtime_t realTimeBegin;
+  std::vector<int64_t> hardwareTimes;
+  std::vector<double> drifts;
+};
+
+/// \brief Clock trajectory stored in a memory-mapped binary file.
+///
+/// The file holds hold points of a clock generated by a previous run: a header
+/// followed by raw hardware timestamps and drift values. Simulation times aren't
+/// stored, hold point k lies at t0 + k * tint.
+class TrajectoryCache
+{
+ public:
+  TrajectoryCache(const TrajectoryCache& source) = delete;
+  TrajectoryCache(TrajectoryCache&& source) = delete;
+  ~TrajectoryCache();
+
+  TrajectoryCache& operator=(const TrajectoryCache& source) = delete;
+  TrajectoryCache& operator=(TrajectoryCache&& source) = delete;
+
+  /// Maps the cache file.
+  ///
+  /// \returns	The cache, or nullptr if the file doesn't exist.
+  ///		If the file doesn't match the properties, cRuntimeError is thrown.
+  static std::unique_ptr<TrajectoryCache> open(const std::experimental::filesystem::path& path,
+                                               const SteinhauserClock::Properties& properties);
+
+  /// \returns	The number of cached hold points.
+  size_t size() const
+  {
+    return count;
+  }
+
+  /// Returns the hold point at index k.
+  ///
+  /// If the index is out of bounds, cRuntimeError is thrown.
+  StorageWindow::HoldPoint at(size_t k) const;
+
+  /// Calculates the hold point index for a timestamp.
+  ///
+  /// \param t	A simulation timestamp.
+  /// \returns	The index of the hold point in what the simulation time lies.
+  size_t indexOf(const omnetpp::simtime_t& t) const;
+
+  /// Calculates the hold point index for a hardware timestamp.
+  ///
+  /// \param t	A hardware timestamp.
+  /// \returns	The index of the last hold point whose hardware time is
+  ///		lower than t, or 0 if there is no such hold point.
+  size_t hardwareIndexOf(const omnetpp::simtime_t& t) const;
+
+  /// Returns the hardware timestamp of the first point after the cached hold points.
+  omnetpp::simtime_t hardwareTimeEnd() const;
+
+  /// Returns the simulation timestamp of the first point after the cached hold points.
+  ///
+  /// Simulation times up to (but excluding) this one lie in cached intervals.
+  omnetpp::simtime_t realTimeEnd() const;
+
+ private:
+  TrajectoryCache() = default;
+
+  const SteinhauserClock::Properties* properties{nullptr};
+  void* mapping{nullptr};
+  size_t mappingSize{0};
+  size_t count{0};
+  omnetpp::simtime_t realTimeBegin;
+  const int64_t* hardwareTimes{nullptr};
+  const double* drifts{nullptr};
+};
+
+}  // namespace steinhauser_clock
+}  // namespace smile
@@ -0,0 +1,122 @@
+//
+// Copyright (C) 2018 Tomasz Jankowski <t.jankowski AT pwr.edu.pl>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "VectorSummary.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+using namespace omnetpp;
+
+namespace smile {
+namespace steinhauser_clock {
+
+namespace {
+
+const char fileMagic[8] = {'S', 'M', 'I', 'L', 'E', 'V', 'S', 'M'};
+const uint32_t fileVersion = 1;
+
+struct FileHeader
+{
+  char magic[8];
+  uint32_t version;
+  int32_t scaleExponent;
+  uint64_t bucketSize;
+  uint64_t bucketCount;
+};
+
+template <typename T>
+void writeColumn(std::ofstream& stream, const std::vector<T>& column)
+{
+  stream.write(reinterpret_cast<const char*>(column.data()), column.size() * sizeof(T));
+}
+
+}  // namespace
+
+VectorSummary::VectorSummary(size_t bucketSize, const std::string& filePath) :
+    bucketSize(std::max<size_t>(bucketSize, 1)),
+    filePath(filePath)
+{}
+
+void VectorSummary::collect(const simtime_t& realTime, double drift, double deviation)
+{
+  if (count == 0) {
+    begin = realTime;
+    driftMin = driftMax = drift;
+    deviationMin = deviationMax = deviation;
+    driftSum = deviationSum = 0;
+  }
+
+  driftMin = std::min(driftMin, drift);
+  driftMax = std::max(driftMax, drift);
+  driftSum += drift;
+  deviationMin = std::min(deviationMin, deviation);
+  deviationMax = std::max(deviationMax, deviation);
+  deviationSum += deviation;
+
+  if (++count == bucketSize) {
+    closeBucket();
+  }
+}
+
+void VectorSummary::closeBucket()
+{
+  begins.push_back(begin.raw());
+  counts.push_back(count);
+  drifts.min.push_back(driftMin);
+  drifts.max.push_back(driftMax);
+  drifts.mean.push_back(driftSum / count);
+  deviations.min.push_back(deviationMin);
+  deviations.max.push_back(deviationMax);
+  deviations.mean.push_back(deviationSum / count);
+  count = 0;
+}
+
+void VectorSummary::finish()
+{
+  if (count > 0) {
+    closeBucket();
+  }
+
+  FileHeader header;
+  std::memcpy(header.magic, fileMagic, sizeof(fileMagic));
+  header.version = fileVersion;
+  header.scaleExponent = SimTime::getScaleExp();
+  header.bucketSize = bucketSize;
+  header.bucketCount = begins.size();
+
+  try {
+    std::ofstream stream;
+    stream.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+    stream.open(filePath, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writeColumn(stream, begins);
+    writeColumn(stream, drifts.min);
+    writeColumn(stream, drifts.max);
+    writeColumn(stream, drifts.mean);
+    writeColumn(stream, deviations.min);
+    writeColumn(stream, deviations.max);
+    writeColumn(stream, deviations.mean);
+    writeColumn(stream, counts);
+  }
+  catch (const std::ios_base::failure& error) {
+    throw cRuntimeError{"Failed to write clock vector summary \"%s\": %s", filePath.c_str(), error.what()};
+  }
+}
+
+}  // namespace steinhauser_clock
+}  // namespace smile
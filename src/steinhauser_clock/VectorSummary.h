@@ -0,0 +1,84 @@
+//
+// Copyright (C) 2018 Tomasz Jankowski <t.jankowski AT pwr.edu.pl>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#pragma once
+
+#include <omnetpp.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace smile {
+namespace steinhauser_clock {
+
+/// \brief Low-overhead replacement of drift and time deviation vectors.
+///
+/// Hold points are grouped into buckets of fixed size and only minimum,
+/// maximum and mean of drift and time deviation of every bucket are kept.
+/// At the end of the run buckets are written to a binary file, column by column:
+/// a header, bucket begin timestamps (raw simtime_t), six columns of doubles
+/// (drift min/max/mean, deviation min/max/mean) and hold point counts.
+class VectorSummary
+{
+ public:
+  /// Initializes the summary.
+  ///
+  /// \param bucketSize	The number of hold points summarized by a single bucket.
+  /// \param filePath	Path of the output file.
+  VectorSummary(size_t bucketSize, const std::string& filePath);
+
+  /// Adds a hold point to the current bucket.
+  ///
+  /// \param realTime	The simulation timestamp, has to be increasing between calls.
+  /// \param drift	The drift value at realTime.
+  /// \param deviation	The deviation between the hardware and simulation time at realTime.
+  void collect(const omnetpp::simtime_t& realTime, double drift, double deviation);
+
+  /// Closes the current bucket and writes the file.
+  void finish();
+
+ private:
+  struct Column
+  {
+    std::vector<double> min;
+    std::vector<double> max;
+    std::vector<double> mean;
+  };
+
+  void closeBucket();
+
+  size_t bucketSize;
+  std::string filePath;
+
+  std::vector<int64_t> begins;
+  std::vector<uint32_t> counts;
+  Column drifts;
+  Column deviations;
+
+  /// State of the current bucket.
+  size_t count{0};
+  omnetpp::simtime_t begin;
+  double driftMin{0};
+  double driftMax{0};
+  double driftSum{0};
+  double deviationMin{0};
+  double deviationMax{0};
+  double deviationSum{0};
+};
+
+}  // namespace steinhauser_clock
+}  // namespace smile
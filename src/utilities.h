@@ -58,4 +58,36 @@ class SequenceNumberGenerator final
   T current{0};
 };
 
+// Caches a value for the duration of a single simulation event, so repeated reads within the event are cheap.
+// Values computed during network initialization are cached until the first event.
+template <typename T>
+class EventMemo final
+{
+ public:
+  EventMemo() = default;
+  EventMemo(const EventMemo&) = default;
+  EventMemo(EventMemo&&) = default;
+  ~EventMemo() = default;
+
+  EventMemo& operator=(const EventMemo&) = default;
+  EventMemo& operator=(EventMemo&&) = default;
+
+  // Returns the cached value, or the result of calling compute if nothing was cached during the current event
+  template <typename Function>
+  const T& get(Function&& compute)
+  {
+    const auto eventNumber = omnetpp::getSimulation()->getEventNumber();
+    if (eventNumber != cachedEventNumber) {
+      value = compute();
+      cachedEventNumber = eventNumber;
+    }
+
+    return value;
+  }
+
+ private:
+  T value{};
+  omnetpp::eventnumber_t cachedEventNumber{-1};
+};
+
 }  // namespace smile
@@ -16,6 +16,7 @@
 #include <cassert>
 
 #include "FakeIdealApplication.h"
+#include "utilities.h"
 
 namespace smile {
 namespace fakes {
@@ -61,23 +62,70 @@ void FakeIdealApplication::handleSelfMessage(cMessage* message)
 
 void FakeIdealApplication::handleIncommingMessage(cMessage* newMessage)
 {
-  std::unique_ptr<cMessage> message{newMessage};
-  EV_DETAIL_C("FakeIdealApplication") << "Received frame (" << message->getClassName() << ")\""
-                                      << message->getFullName() << "\"" << endl;
+  auto frame = dynamic_unique_ptr_cast<inet::IdealMacFrame>(std::unique_ptr<cMessage>{newMessage});
+  EV_DETAIL_C("FakeIdealApplication") << "Received frame (" << frame->getClassName() << ")\"" << frame->getFullName()
+                                      << "\"" << endl;
+  if (lastRxCompletion) {
+    EV_DETAIL_C("FakeIdealApplication") << "RX completion frame cleared after notification: "
+                                        << std::boolalpha << (lastRxCompletion->frame == nullptr) << endl;
+  }
+
+  const auto sourceAddress = frame->getSrc();
+  const auto name = std::string{"Echo of "} + frame->getName();
+  const auto receivedFrameId = frame->getId();
+  recycleFrame(std::move(frame));
+
+  if (par("echo").boolValue()) {
+    auto echoFrame = createFrame<inet::IdealMacFrame>(sourceAddress, name.c_str());
+    echoFrame->setBitLength(10);
+    EV_DETAIL_C("FakeIdealApplication") << "Echo frame has new ID: " << std::boolalpha
+                                        << (echoFrame->getId() != receivedFrameId) << endl;
+    send(echoFrame.release(), "out");
+  }
 }
 
 void FakeIdealApplication::handleTxCompletionSignal(const IdealTxCompletion& completion)
 {
-  EV_DETAIL_C("FakeIdealApplication") << "Transmission of frame (" << completion.getFrame()->getClassName() << ")\""
-                                      << completion.getFrame()->getFullName() << "\" started at "
-                                      << completion.getOperationBeginClockTimestamp() << endl;
+  logTxCompletion(*completion.getFrame(), completion.getOperationBeginClockTimestamp());
 }
 
 void FakeIdealApplication::handleRxCompletionSignal(const IdealRxCompletion& completion)
 {
-  EV_DETAIL_C("FakeIdealApplication") << "Reception of frame (" << completion.getFrame()->getClassName() << ")\""
-                                      << completion.getFrame()->getFullName() << "\" started at "
-                                      << completion.getOperationBeginClockTimestamp() << endl;
+  logRxCompletion(*completion.getFrame(), completion.getOperationBeginClockTimestamp(),
+                  completion.getOperationEndClockTimestamp());
+}
+
+void FakeIdealApplication::handleTxCompletionRecord(const TxCompletion& completion)
+{
+  logTxCompletion(*completion.frame, completion.operationBeginClockTimestamp);
+}
+
+void FakeIdealApplication::handleRxCompletionRecord(const RxCompletion& completion)
+{
+  logRxCompletion(*completion.frame, completion.operationBeginClockTimestamp, completion.operationEndClockTimestamp);
+  lastRxCompletion = &completion;
+}
+
+void FakeIdealApplication::logTxCompletion(const inet::IdealMacFrame& frame, const SimTime& beginClockTimestamp)
+{
+  EV_DETAIL_C("FakeIdealApplication") << "Transmission of frame (" << frame.getClassName() << ")\""
+                                      << frame.getFullName() << "\" started at " << beginClockTimestamp << " ("
+                                      << frame.getSrc() << " -> " << frame.getDest() << ")" << endl;
+  if (previousTxCompletionFrame) {
+    EV_DETAIL_C("FakeIdealApplication") << "TX completion frame snapshot reused: " << std::boolalpha
+                                        << (&frame == previousTxCompletionFrame) << endl;
+  }
+  previousTxCompletionFrame = &frame;
+}
+
+void FakeIdealApplication::logRxCompletion(const inet::IdealMacFrame& frame, const SimTime& beginClockTimestamp,
+                                           const SimTime& endClockTimestamp)
+{
+  EV_DETAIL_C("FakeIdealApplication") << "Reception of frame (" << frame.getClassName() << ")\""
+                                      << frame.getFullName() << "\" started at " << beginClockTimestamp << " ("
+                                      << frame.getSrc() << " -> " << frame.getDest() << ")" << endl;
+  EV_DETAIL_C("FakeIdealApplication") << "Reception of frame \"" << frame.getFullName() << "\" lasted from "
+                                      << beginClockTimestamp << " to " << endClockTimestamp << endl;
 }
 
 }  // namespace fakes
@@ -42,8 +42,19 @@ class FakeIdealApplication : public IdealApplication
 
   void handleRxCompletionSignal(const IdealRxCompletion& completion) override;
 
+  void handleTxCompletionRecord(const TxCompletion& completion) override;
+
+  void handleRxCompletionRecord(const RxCompletion& completion) override;
+
+  void logTxCompletion(const inet::IdealMacFrame& frame, const SimTime& beginClockTimestamp);
+
+  void logRxCompletion(const inet::IdealMacFrame& frame, const SimTime& beginClockTimestamp,
+                       const SimTime& endClockTimestamp);
+
   std::unique_ptr<omnetpp::cMessage> periodicTxMessage;
   unsigned int completedTxOperations{0};
+  const inet::IdealMacFrame* previousTxCompletionFrame{nullptr};
+  const RxCompletion* lastRxCompletion{nullptr};
 };
 
 }  // namespace fakes
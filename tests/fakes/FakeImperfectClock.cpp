@@ -16,6 +16,7 @@
 #include "inet/common/INETDefs.h"
 
 #include "FakeImperfectClock.h"
+#include <algorithm>
 
 namespace smile {
 namespace fakes {
@@ -49,6 +50,7 @@ void FakeImperfectClock::handleMessage(omnetpp::cMessage* message)
   currentWindowEndTimestamp = simTime() + windowDuration;
   scheduleAt(currentWindowEndTimestamp, windowUpdateSelfMessage.get());
 
+  releaseTimers();
   emit(IClock::windowUpdateSignal, currentWindowEndTimestamp);
 
   EV_DEBUG << "Emit periodic signal " << getSignalName(IClock::windowUpdateSignal) << endl;
@@ -64,5 +66,13 @@ FakeImperfectClock::OptionalSimTime FakeImperfectClock::convertToSimulationTimes
   return timestamp > currentWindowEndTimestamp ? std::experimental::nullopt : OptionalSimTime{timestamp};
 }
 
+size_t FakeImperfectClock::convertToSimulationTimestamps(const std::vector<omnetpp::SimTime>& timestamps,
+                                                         std::vector<omnetpp::SimTime>& simulationTimestamps)
+{
+  const auto end = std::upper_bound(timestamps.begin(), timestamps.end(), currentWindowEndTimestamp);
+  simulationTimestamps.assign(timestamps.begin(), end);
+  return simulationTimestamps.size();
+}
+
 }  // namespace fakes
 }  // namespace smile
@@ -16,6 +16,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 #include "IClock.h"
 #include "omnetpp.h"
 
@@ -35,6 +36,8 @@ class FakeImperfectClock : public omnetpp::cSimpleModule, public IClock
 
   omnetpp::SimTime getClockTimestamp() override;
   OptionalSimTime convertToSimulationTimestamp(const omnetpp::SimTime& timestamp) override;
+  size_t convertToSimulationTimestamps(const std::vector<omnetpp::SimTime>& timestamps,
+                                       std::vector<omnetpp::SimTime>& simulationTimestamps) override;
 
  protected:
   void initialize(int stage) override;
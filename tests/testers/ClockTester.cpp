@@ -15,7 +15,15 @@
 
 #include "ClockTester.h"
 #include <inet/common/ModuleAccess.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
 #include "IClock.h"
+#include "LiuYangClock.h"
+#include "steinhauser_clock/SteinhauserClock.h"
+#include "steinhauser_clock/StorageWindow.h"
 
 namespace smile {
 namespace testers {
@@ -54,6 +62,218 @@ void checkTimestamp(const SimTime& timestamp, const SimTime& reference_timestamp
   EV_INFO << "\tSUCCESS\n";
 }
 
+SimTime scanConvertToSimulationTimestamp(const steinhauser_clock::StorageWindow& storageWindow,
+                                         const SimTime& timestamp)
+{
+  // Reference implementation, walks forward from the current hold point
+  const auto lastIndex = storageWindow.size() - 1;
+  auto k = storageWindow.indexOf(simTime());
+  while (k != lastIndex && storageWindow.at(k + 1).hardwareTime < timestamp) {
+    k++;
+  }
+
+  const auto& hp = storageWindow.at(k);
+  return hp.realTime + (timestamp - hp.hardwareTime) / (1 + hp.drift);
+}
+
+void checkConversionAgainstScan(steinhauser_clock::SteinhauserClock& clock)
+{
+  const auto& storageWindow = *clock.getStorageWindow();
+  const auto begin = storageWindow.hardwareTimeBegin();
+  const auto end = storageWindow.hardwareTimeEnd();
+  const auto stepsNumber = 10000;
+
+  EV_INFO << "CHECK if converted times match linear scan in window: < " << simtime_to_string(begin) << ", "
+          << simtime_to_string(end) << " >\n";
+
+  for (auto i = 0; i <= stepsNumber; i++) {
+    const auto timestamp = begin + (end - begin) * (static_cast<double>(i) / stepsNumber);
+    const auto referenceTime = scanConvertToSimulationTimestamp(storageWindow, timestamp);
+    const auto convertedTime = clock.convertToSimulationTimestamp(timestamp);
+    if (!convertedTime || *convertedTime != referenceTime) {
+      EV_INFO << "\tClock time: " << simtime_to_string(timestamp) << "\n";
+      EV_INFO << "\tReference time: " << simtime_to_string(referenceTime) << "\n";
+      EV_INFO << "\t!!! FAILURE !!!\n";
+      throw cRuntimeError{"Test failed"};
+    }
+  }
+
+  EV_INFO << "\tSUCCESS\n";
+}
+
+void checkBatchConversion(IClock& clock)
+{
+  const auto begin = clock.getClockTimestamp();
+  const auto stepsNumber = 10000;
+
+  EV_INFO << "CHECK if batch conversion matches single conversions\n";
+
+  std::vector<SimTime> timestamps;
+  for (auto i = 0; i <= stepsNumber; i++) {
+    timestamps.push_back(begin + SimTime(10, SIMTIME_S) * (static_cast<double>(i) / stepsNumber));
+  }
+
+  std::vector<SimTime> convertedTimes;
+  const auto converted = clock.convertToSimulationTimestamps(timestamps, convertedTimes);
+  for (size_t i = 0; i < timestamps.size(); i++) {
+    const auto referenceTime = clock.convertToSimulationTimestamp(timestamps[i]);
+    if (!referenceTime) {
+      if (i == converted) {
+        break;
+      }
+    }
+    else if (i < converted && convertedTimes[i] == *referenceTime) {
+      continue;
+    }
+
+    EV_INFO << "\tClock time: " << simtime_to_string(timestamps[i]) << "\n";
+    EV_INFO << "\t!!! FAILURE !!!\n";
+    throw cRuntimeError{"Test failed"};
+  }
+
+  EV_INFO << "\tSUCCESS\n";
+}
+
+void checkConversionAgainstForward(LiuYangClock& clock)
+{
+  const auto stepsNumber = 10000;
+  const auto tick = SimTime::fromRaw(1);
+
+  EV_INFO << "CHECK if converted times are the earliest ones showing requested clock time\n";
+
+  for (auto i = 0; i <= stepsNumber; i++) {
+    const auto timestamp = SimTime(10, SIMTIME_S) * (static_cast<double>(i) / stepsNumber) + tick * i;
+    const auto convertedTime = clock.convertToSimulationTimestamp(timestamp);
+    if (!convertedTime || clock.hardwareTimestampAt(*convertedTime) < timestamp ||
+        clock.hardwareTimestampAt(*convertedTime - tick) >= timestamp) {
+      EV_INFO << "\tClock time: " << simtime_to_string(timestamp) << "\n";
+      EV_INFO << "\t!!! FAILURE !!!\n";
+      throw cRuntimeError{"Test failed"};
+    }
+  }
+
+  EV_INFO << "\tSUCCESS\n";
+}
+
+void checkConversionsAgainstFile(IClock& clock, const std::string& fileName)
+{
+  const auto stepsNumber = 1000;
+
+  std::vector<int64_t> convertedTimes;
+  for (auto i = 0; i <= stepsNumber; i++) {
+    const auto timestamp = SimTime(9, SIMTIME_S) * (static_cast<double>(i) / stepsNumber);
+    const auto convertedTime = clock.convertToSimulationTimestamp(timestamp);
+    convertedTimes.push_back(convertedTime ? convertedTime->raw() : -1);
+  }
+
+  std::ifstream input{fileName};
+  if (!input) {
+    // the first run writes conversions, the following ones compare with them
+    std::ofstream output{fileName};
+    for (const auto convertedTime : convertedTimes) {
+      output << convertedTime << "\n";
+    }
+
+    EV_INFO << "Conversions written to " << fileName << "\n";
+    return;
+  }
+
+  EV_INFO << "CHECK if converted times match the ones from " << fileName << "\n";
+
+  for (const auto convertedTime : convertedTimes) {
+    int64_t referenceTime;
+    if (!(input >> referenceTime) || referenceTime != convertedTime) {
+      EV_INFO << "\t!!! FAILURE !!!\n";
+      throw cRuntimeError{"Test failed"};
+    }
+  }
+
+  EV_INFO << "\tSUCCESS\n";
+}
+
+template <typename T>
+std::vector<T> readColumn(std::ifstream& input, size_t size)
+{
+  std::vector<T> column(size);
+  input.read(reinterpret_cast<char*>(column.data()), size * sizeof(T));
+  return column;
+}
+
+void checkVectorSummary(const std::string& fileName, size_t bucketSize,
+                        const std::vector<steinhauser_clock::StorageWindow::HoldPoint>& firstBucket,
+                        uint64_t holdPointsCount)
+{
+  EV_INFO << "CHECK if vector summary matches recorded hold points: " << fileName << "\n";
+
+  // Layout described in VectorSummary.h
+  std::ifstream input{fileName, std::ios_base::binary};
+  char magic[8];
+  uint32_t version{0};
+  int32_t scaleExponent{0};
+  uint64_t fileBucketSize{0};
+  uint64_t bucketCount{0};
+  input.read(magic, sizeof(magic));
+  input.read(reinterpret_cast<char*>(&version), sizeof(version));
+  input.read(reinterpret_cast<char*>(&scaleExponent), sizeof(scaleExponent));
+  input.read(reinterpret_cast<char*>(&fileBucketSize), sizeof(fileBucketSize));
+  input.read(reinterpret_cast<char*>(&bucketCount), sizeof(bucketCount));
+
+  const auto expectedBucketCount = (holdPointsCount + bucketSize - 1) / bucketSize;
+  EV_INFO << "\tHold points: " << holdPointsCount << ", buckets: " << bucketCount << "\n";
+  if (!input || std::memcmp(magic, "SMILEVSM", sizeof(magic)) != 0 || version != 1 ||
+      scaleExponent != SimTime::getScaleExp() || fileBucketSize != bucketSize || bucketCount != expectedBucketCount) {
+    EV_INFO << "\t!!! FAILURE !!!\n";
+    throw cRuntimeError{"Test failed"};
+  }
+
+  const auto begins = readColumn<int64_t>(input, bucketCount);
+  const auto driftMins = readColumn<double>(input, bucketCount);
+  const auto driftMaxs = readColumn<double>(input, bucketCount);
+  const auto driftMeans = readColumn<double>(input, bucketCount);
+  const auto deviationMins = readColumn<double>(input, bucketCount);
+  const auto deviationMaxs = readColumn<double>(input, bucketCount);
+  const auto deviationMeans = readColumn<double>(input, bucketCount);
+  const auto counts = readColumn<uint32_t>(input, bucketCount);
+  if (!input || input.peek() != std::ifstream::traits_type::eof()) {
+    EV_INFO << "\t!!! FAILURE !!!\n";
+    throw cRuntimeError{"Test failed"};
+  }
+
+  uint64_t countsSum{0};
+  for (const auto count : counts) {
+    countsSum += count;
+  }
+
+  // The first bucket is computed the same way as VectorSummary::collect() does
+  auto driftMin = firstBucket.front().drift;
+  auto driftMax = driftMin;
+  double driftSum{0};
+  auto deviationMin = (firstBucket.front().hardwareTime - firstBucket.front().realTime).dbl();
+  auto deviationMax = deviationMin;
+  double deviationSum{0};
+  for (const auto& holdPoint : firstBucket) {
+    const auto deviation = (holdPoint.hardwareTime - holdPoint.realTime).dbl();
+    driftMin = std::min(driftMin, holdPoint.drift);
+    driftMax = std::max(driftMax, holdPoint.drift);
+    driftSum += holdPoint.drift;
+    deviationMin = std::min(deviationMin, deviation);
+    deviationMax = std::max(deviationMax, deviation);
+    deviationSum += deviation;
+  }
+
+  EV_INFO << "\tFirst bucket drift: < " << driftMins[0] << ", " << driftMaxs[0] << " >, mean: " << driftMeans[0]
+          << ", count: " << counts[0] << "\n";
+  if (countsSum != holdPointsCount || begins[0] != firstBucket.front().realTime.raw() ||
+      counts[0] != firstBucket.size() || driftMins[0] != driftMin || driftMaxs[0] != driftMax ||
+      driftMeans[0] != driftSum / firstBucket.size() || deviationMins[0] != deviationMin ||
+      deviationMaxs[0] != deviationMax || deviationMeans[0] != deviationSum / firstBucket.size()) {
+    EV_INFO << "\t!!! FAILURE !!!\n";
+    throw cRuntimeError{"Test failed"};
+  }
+
+  EV_INFO << "\tSUCCESS\n";
+}
+
 void ClockTester::initialize(int stage)
 {
   ClockDecorator<cSimpleModule>::initialize(stage);
@@ -91,12 +311,57 @@ void ClockTester::initialize(int stage)
       checkTimestamp(*(clock->convertToSimulationTimestamp(referenceTime)), referenceTime, drift_range);
     }
 
+    // Test time conversion against reference hold point scan
+    auto steinhauserClock = dynamic_cast<steinhauser_clock::SteinhauserClock*>(clock);
+    if (steinhauserClock && steinhauserClock->getStorageWindow()) {
+      checkConversionAgainstScan(*steinhauserClock);
+    }
+
+    checkBatchConversion(*clock);
+
+    const std::string conversionsFile = par("conversionsFile").stdstringValue();
+    if (!conversionsFile.empty()) {
+      checkConversionsAgainstFile(*clock, conversionsFile);
+    }
+
+    vectorSummaryFile = par("vectorSummaryFile").stdstringValue();
+    if (!vectorSummaryFile.empty()) {
+      if (!steinhauserClock || !steinhauserClock->getStorageWindow()) {
+        throw cRuntimeError{"Vector summary can be checked only for clocks with storage window"};
+      }
+
+      vectorSummaryBucketSize = clockModule->par("vectorBucket").longValue();
+      const auto& storageWindow = *steinhauserClock->getStorageWindow();
+      for (size_t i = 0; i < std::min(vectorSummaryBucketSize, storageWindow.size()); i++) {
+        firstBucketHoldPoints.push_back(storageWindow.at(i));
+      }
+    }
+
+    auto liuYangClock = dynamic_cast<LiuYangClock*>(clock);
+    if (liuYangClock) {
+      checkConversionAgainstForward(*liuYangClock);
+    }
+
     // Send messages
 
     // TODO
   }
 }
 
+void ClockTester::finish()
+{
+  ClockDecorator<cSimpleModule>::finish();
+
+  if (!vectorSummaryFile.empty()) {
+    // Hold points are generated every tint from time 0, the last one is at the end of the storage window
+    const auto& storageWindow = *check_and_cast<steinhauser_clock::SteinhauserClock*>(clock)->getStorageWindow();
+    const auto tint = storageWindow.at(1).realTime - storageWindow.at(0).realTime;
+    const auto lastRealTime = storageWindow.at(storageWindow.size() - 1).realTime;
+    const uint64_t holdPointsCount = lastRealTime.raw() / tint.raw() + 1;
+    checkVectorSummary(vectorSummaryFile, vectorSummaryBucketSize, firstBucketHoldPoints, holdPointsCount);
+  }
+}
+
 int ClockTester::numInitStages() const
 {
   return inet::INITSTAGE_APPLICATION_LAYER + 1;
@@ -15,7 +15,10 @@
 
 #pragma once
 
+#include <string>
+#include <vector>
 #include "ClockDecorator.h"
+#include "steinhauser_clock/StorageWindow.h"
 
 namespace smile {
 namespace testers {
@@ -36,7 +39,14 @@ class ClockTester : public ClockDecorator<omnetpp::cSimpleModule>
 
   int numInitStages() const override;
 
+  // Checks vector summary written by the clock, clock finishes before the tester
+  void finish() override;
+
   IClock* clock{nullptr};
+  std::string vectorSummaryFile;
+  size_t vectorSummaryBucketSize{0};
+  // Hold points of the first bucket of the vector summary, taken before the storage window slides
+  std::vector<steinhauser_clock::StorageWindow::HoldPoint> firstBucketHoldPoints;
 };
 
 }  // namespace testers